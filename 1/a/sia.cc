@@ -1,10 +1,35 @@
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <numeric>
-#include <stack>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fastio.h"
+
 //#define DEBUG
 
 #ifdef DEBUG
@@ -13,23 +38,476 @@ constexpr const bool debug = true;
 constexpr const bool debug = false;
 #endif
 
+//#define EYTZINGER
+
+// Read-only elements, owned by a vector or mapped from a snapshot.
+template<class T>
+class view_t {
+    public:
+    view_t()
+    : first{nullptr}
+    , count{0}
+    { }
+
+    view_t(const T *first, size_t count)
+    : first{first}
+    , count{count}
+    { }
+
+    view_t(const std::vector<T> &values)
+    : view_t{values.data(), values.size()}
+    { }
+
+    const T& operator[](size_t idx) const {
+        return first[idx];
+    }
+
+    const T* data() const {
+        return first;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    private:
+    const T *first;
+    size_t count;
+};
+
+// Search engines for the first rate not less than a threshold within
+// [left, right) of the sorted rates.
+template<class Rate, class Position>
+class binary_search_t {
+    public:
+    void build(view_t<Rate>) { }
+
+    Position first_not_less_than(view_t<Rate> rates, const Rate &threshold,
+            Position left, Position right) const {
+        while(left != right) {
+            auto mid = (left + right) / 2;
+
+            if(rates[mid] < threshold) {
+                left = mid + 1;
+            }
+            else {
+                right = mid;
+            }
+        }
+
+        return left;
+    }
+};
+
+// Keeps a copy of the rates in BFS order (node k has children 2k and 2k+1),
+// so that the first levels of every search share a few cache lines and the
+// descendants three levels down can be prefetched in one go. The tree is
+// padded to a perfect one with maximal rates, which makes the sorted position
+// of a node computable from its index alone.
+template<class Rate, class Position>
+class eytzinger_search_t {
+    public:
+    void build(view_t<Rate> rates) {
+        height = 0;
+        while((size_t{1} << height) <= rates.size())
+            ++height;
+
+        tree.assign(size_t{1} << height, std::numeric_limits<Rate>::max());
+        size_t next{0};
+        fill(rates, next, 1);
+    }
+
+    Position first_not_less_than(view_t<Rate> rates, const Rate &threshold,
+            const Position &left, const Position &right) const {
+        static constexpr const size_t per_line = 64 / sizeof(Rate);
+        const auto size = tree.size();
+
+        size_t k = 1;
+        while(k < size) {
+            __builtin_prefetch(tree.data() + std::min(k * per_line, size - 1));
+            k = 2 * k + (tree[k] < threshold);
+        }
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+
+        const auto found = k == 0 ? rates.size() : inorder(k);
+        return std::max(left, std::min(right, static_cast<Position>(found)));
+    }
+
+    private:
+    std::vector<Rate> tree;
+    unsigned height;
+
+    size_t inorder(size_t k) const {
+        const auto depth = static_cast<unsigned>(63 - __builtin_clzll(k));
+        return ((2 * (k - (size_t{1} << depth)) + 1) << (height - 1 - depth)) - 1;
+    }
+
+    void fill(view_t<Rate> rates, size_t &next, size_t k) {
+        if(k >= tree.size())
+            return;
+
+        fill(rates, next, 2 * k);
+        if(next < rates.size())
+            tree[k] = rates[next];
+        ++next;
+        fill(rates, next, 2 * k + 1);
+    }
+};
+
+#ifdef EYTZINGER
+template<class Rate, class Position>
+using default_search_t = eytzinger_search_t<Rate, Position>;
+#else
+template<class Rate, class Position>
+using default_search_t = binary_search_t<Rate, Position>;
+#endif
+
+// Runs fn(thread, begin, end) on threads contiguous chunks of [0, size).
+template<class Fn>
+void parallel_for(unsigned threads, size_t size, Fn &&fn) {
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, size)));
+    if(threads == 1) {
+        fn(0u, size_t{0}, size);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for(unsigned thread = 0; thread < threads; ++thread)
+        workers.emplace_back([&fn, thread, threads, size] {
+            fn(thread, size * thread / threads, size * (thread + 1) / threads);
+        });
+
+    for(auto &worker: workers)
+        worker.join();
+}
+
+// LSD radix sort on bytes. Every pass histograms the per-thread chunks and
+// scatters them into a buffer; passes over a byte shared by all values are
+// skipped, which for small rates leaves only the low ones.
+template<class T>
+void parallel_sort(std::vector<T> &values, unsigned threads, std::true_type /* integral */) {
+    using key_t = typename std::make_unsigned<T>::type;
+    static constexpr const key_t sign = std::is_signed<T>::value ? key_t{1} << (sizeof(T) * 8 - 1) : 0;
+    static constexpr const size_t RADIX = 256;
+
+    const auto size = values.size();
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, size)));
+    std::vector<T> buffer(size);
+    std::vector<std::array<size_t, RADIX>> offsets(threads);
+
+    for(unsigned shift = 0; shift < sizeof(T) * 8; shift += 8) {
+        const auto digit = [shift](const T &value) {
+            return static_cast<size_t>(((static_cast<key_t>(value) ^ sign) >> shift) & (RADIX - 1));
+        };
+
+        parallel_for(threads, size, [&](unsigned thread, size_t begin, size_t end) {
+            auto &count = offsets[thread];
+            count.fill(0);
+            for(auto i = begin; i < end; ++i)
+                ++count[digit(values[i])];
+        });
+
+        size_t total = 0;
+        bool trivial = false;
+        for(size_t d = 0; d < RADIX; ++d) {
+            size_t in_bucket = 0;
+            for(auto &count: offsets) {
+                in_bucket += count[d];
+                const auto here = count[d];
+                count[d] = total;
+                total += here;
+            }
+            trivial = trivial || in_bucket == size;
+        }
+
+        if(trivial)
+            continue;
+
+        parallel_for(threads, size, [&](unsigned thread, size_t begin, size_t end) {
+            auto &offset = offsets[thread];
+            for(auto i = begin; i < end; ++i)
+                buffer[offset[digit(values[i])]++] = values[i];
+        });
+
+        values.swap(buffer);
+    }
+}
+
+template<class T>
+void parallel_sort(std::vector<T> &values, unsigned, std::false_type /* integral */) {
+    std::sort(std::begin(values), std::end(values));
+}
+
+template<class T>
+void parallel_sort(std::vector<T> &values, unsigned threads) {
+    parallel_sort(values, threads, std::is_integral<T>{});
+}
+
+// Two passes: the chunk totals, then the chunks again offset by the totals
+// of the chunks before them.
+template<class T, class Sum>
+void parallel_partial_sum(const std::vector<T> &values, std::vector<Sum> &sums, unsigned threads) {
+    const auto size = values.size();
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, size)));
+    sums.resize(size);
+    std::vector<Sum> totals(threads + 1, Sum{0});
+
+    parallel_for(threads, size, [&](unsigned thread, size_t begin, size_t end) {
+        totals[thread + 1] = std::accumulate(values.data() + begin, values.data() + end, Sum{0});
+    });
+
+    std::partial_sum(std::begin(totals), std::end(totals), std::begin(totals));
+
+    parallel_for(threads, size, [&](unsigned thread, size_t begin, size_t end) {
+        auto sum = totals[thread];
+        for(auto i = begin; i < end; ++i)
+            sums[i] = sum += values[i];
+    });
+}
+
+// The whole token as a decimal number. False for a stray word, trailing
+// garbage or an overflow, which the long-running modes answer with NIE
+// instead of stopping.
+inline bool parse_number(const std::string &token, long long &value) {
+    char *parsed;
+    errno = 0;
+    value = strtoll(token.c_str(), &parsed, 10);
+    return errno == 0 && !token.empty() && *parsed == '\0';
+}
+
 template<class Height = long long, class Time = long long,
-         class Rate = long long, class Position = size_t>
+         class Rate = long long, class Position = size_t,
+         class Search = default_search_t<Rate, Position>>
 class solver_t {
     public:
-    void solve() && {
-        prepare();
+    // threads only affects sorting the rates and computing their prefix sums
+    explicit solver_t(unsigned threads = 1)
+    : threads{threads}
+    { }
+
+    template<class Input, class Output>
+    void solve(Input &in, Output &out) && {
+        prepare(in);
 
         for(int i = 0; i < m; ++i) {
-            read_line();
+            read_line(in, out);
         }
     }
 
+    // Same as above, for a field whose header and rates were already read;
+    // rates must start with a 0 for the sentinel.
+    template<class Input, class Output>
+    void solve(Input &in, Output &out, const Position &n, int m, std::vector<Rate> &&rates) && {
+        this->n = n;
+        this->m = m;
+        growth_rate = std::move(rates);
+        prepare_rates();
+
+        for(int i = 0; i < m; ++i) {
+            read_line(in, out);
+        }
+    }
+
+    // Same as above, but the state is saved to snapshot every that many
+    // queries. If snapshot already holds the state for this input, the rates
+    // are not sorted again but mapped from it, and the queries processed so
+    // far are skipped instead of recomputed. Answers printed after the last
+    // snapshot are printed again on resume.
+    template<class Input, class Output>
+    void solve(Input &in, Output &out, const char *snapshot, int every) && {
+        in >> n >> m;
+
+        // A mapped input file is identified without reading its rates and
+        // resuming jumps straight to the first query not processed yet.
+        // Anything else is tied to the snapshot by a hash of its rates.
+        input = identify(0);
+        const bool seekable = input.size != 0 && in.seek(in.position());
+        if(!seekable) {
+            input = fingerprint_t{};
+            parse_rates(in);
+            input.rates_hash = checksum(reinterpret_cast<const char*>(growth_rate.data()),
+                                        growth_rate.size() * sizeof(Rate));
+        }
+
+        if(restore(snapshot)) {
+            if(seekable)
+                in.seek(resume_position);
+            else
+                in.skip(2 * static_cast<Position>(processed));
+        }
+        else {
+            if(seekable)
+                parse_rates(in);
+            prepare_rates();
+        }
+
+        while(processed < m) {
+            read_line(in, out);
+            ++processed;
+
+            if(processed % every == 0 || processed == m) {
+                out.flush();
+                save(snapshot, in.position());
+            }
+        }
+    }
+
+    // Long-running mode: the field is loaded once (m is ignored) and every
+    // "day level" pair of each stream passed to serve() is answered with the
+    // harvest, flushed immediately. Days must not decrease, also across
+    // streams; a query going back in time is answered with NIE.
+    static constexpr size_t block_size() {
+        return sizeof(block_t);
+    }
+
+    template<class Input>
+    void load(Input &in) {
+        prepare(in);
+    }
+
+    // A "? day level" line asks what the cut would yield without performing it.
+    // "checkpoint" remembers the current state and is answered with the number
+    // of checkpoints held; "rollback" returns to the latest one and drops it.
+    template<class Input, class Output>
+    void serve(Input &in, Output &out) {
+        using clock = std::chrono::steady_clock;
+        std::vector<long long> latencies;
+
+        std::string token, level_token;
+        while(in >> token) {
+            if(token == "checkpoint") {
+                checkpoint();
+                out << checkpoints.size() << '\n';
+                out.flush();
+                continue;
+            }
+
+            if(token == "rollback") {
+                out << (rollback() ? "OK\n" : "NIE\n");
+                out.flush();
+                continue;
+            }
+
+            const bool hypothetical = token == "?";
+            if(hypothetical && !(in >> token))
+                break;
+
+            if(!(in >> level_token))
+                break;
+
+            // A day or level that is not a number is answered with NIE like
+            // any other invalid query, one bad client line must not stop the
+            // server.
+            long long day, level;
+            const bool valid = parse_number(token, day) && parse_number(level_token, level);
+
+            const auto start = clock::now();
+
+            if(!valid || static_cast<Time>(day) < last_day)
+                out << "NIE\n";
+            else if(hypothetical)
+                out << harvest(static_cast<Time>(day), static_cast<Height>(level)) << '\n';
+            else
+                out << cut(static_cast<Time>(day), static_cast<Height>(level)) << '\n';
+            out.flush();
+
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start).count());
+        }
+
+        report_latencies(std::move(latencies));
+    }
+
+    // Checkpoints are O(1). While any is held, every cut journals the blocks
+    // it pops, so rolling back costs as much as the blocks popped since.
+    void checkpoint() {
+        checkpoints.push_back({journal.size(), last_day});
+    }
+
+    bool rollback() {
+        if(checkpoints.empty())
+            return false;
+
+        const auto target = checkpoints.back();
+        checkpoints.pop_back();
+
+        while(journal.size() > target.journal_size) {
+            const auto &entry = journal.back();
+            if(entry.pushed)
+                blocks.pop_back();
+
+            const auto first = std::begin(popped) + static_cast<std::ptrdiff_t>(entry.popped_begin);
+            blocks.insert(std::end(blocks), first, std::end(popped));
+            popped.erase(first, std::end(popped));
+            journal.pop_back();
+        }
+
+        last_day = target.last_day;
+        return true;
+    }
+
+    // Processes the m cuts as solve() does, then answers all the remaining
+    // "day level" lines as hypothetical cuts against the resulting field.
+    template<class Input, class Output>
+    void what_if(Input &in, Output &out, unsigned threads) && {
+        prepare(in);
+
+        for(int i = 0; i < m; ++i) {
+            read_line(in, out);
+        }
+
+        std::vector<std::pair<Time, Height>> queries;
+        Time day;
+        Height level;
+        while(in >> day >> level)
+            queries.emplace_back(day, level);
+
+        const auto results = harvest(queries, threads);
+        for(size_t i = 0; i < queries.size(); ++i) {
+            if(queries[i].first < last_day)
+                out << "NIE\n";
+            else
+                out << results[i] << '\n';
+        }
+    }
+
+    // What cutting at level on day would yield, the field is left intact.
+    Height harvest(const Time &day, const Height &level) const {
+        return walk(day, level).sum;
+    }
+
+    // Many hypothetical cuts at once, split evenly between the threads.
+    // Queries going back in time give meaningless results.
+    std::vector<Height> harvest(const std::vector<std::pair<Time, Height>> &queries,
+            unsigned threads) const {
+        std::vector<Height> results(queries.size());
+        threads = std::max(threads, 1u);
+        const auto chunk = (queries.size() + threads - 1) / threads;
+
+        std::vector<std::thread> workers;
+        for(size_t begin = 0; begin < queries.size(); begin += chunk) {
+            const auto end = std::min(queries.size(), begin + chunk);
+            workers.emplace_back([this, &queries, &results, begin, end] {
+                for(auto i = begin; i < end; ++i)
+                    results[i] = harvest(queries[i].first, queries[i].second);
+            });
+        }
+
+        for(auto &worker: workers)
+            worker.join();
+
+        return results;
+    }
+
     private:
+    unsigned threads;
     Position n;
     int m;
     std::vector<Rate> growth_rate;
-    std::vector<Rate> partial_sums;
+    std::vector<Height> partial_sums;
+    view_t<Rate> rate_view;  // growth_rate, or the rates mapped from a snapshot
+    view_t<Height> sum_view; // the same for partial_sums
+    Search search;
 
     struct block_t {
         Position begin;
@@ -48,76 +526,165 @@ class solver_t {
         }
     };
 
-    std::stack<block_t> blocks;
+    std::vector<block_t> blocks; // a stack, the top is at the back
+    Time last_day{0};
+    int processed{0};
 
-    void prepare() {
-        std::cin >> n >> m;
-        growth_rate.emplace_back(0);
+    struct journal_entry_t {
+        size_t popped_begin; // this cut's blocks in popped, bottom first
+        bool pushed;
+    };
+
+    struct checkpoint_t {
+        size_t journal_size;
+        Time last_day;
+    };
+
+    std::vector<journal_entry_t> journal;
+    std::vector<block_t> popped;
+    std::vector<checkpoint_t> checkpoints;
+
+    // Ties a snapshot to its input: the identity of a regular input file,
+    // or else a hash of the rates in input order.
+    struct fingerprint_t {
+        uint64_t device;
+        uint64_t inode;
+        uint64_t size;
+        int64_t modified; // [ns]
+        uint64_t rates_hash;
+    };
 
-        std::copy_n(
-            std::istream_iterator<Height>(std::cin),
-            n,
-            std::back_inserter(growth_rate)
-        );
+    // A snapshot is two files. path.rates holds the sorted rates and their
+    // prefix sums, which never change, so it is written once and mapped in
+    // place on resume: the header, n + 1 rates padded to 8 bytes and n + 1
+    // partial sums. path itself holds the state: the header and the blocks,
+    // bottom first, with a checksum over both (the checksum field zeroed).
+    struct rates_header_t {
+        char magic[4];
+        uint32_t version;
+        uint32_t sizes;
+        uint32_t reserved;
+        uint64_t n;
+        fingerprint_t input;
+    };
 
-        std::sort(
-            std::begin(growth_rate),
-            std::end(growth_rate)
-        );
+    struct state_header_t {
+        char magic[4];
+        uint32_t version;
+        uint32_t sizes;
+        int32_t m;
+        uint64_t n;
+        uint64_t blocks;
+        int64_t processed;
+        Time last_day;
+        uint64_t position; // of the input after the processed queries
+        fingerprint_t input;
+        uint64_t checksum;
+    };
 
-        std::partial_sum(
-            std::begin(growth_rate),
-            std::end(growth_rate),
-            std::back_inserter(partial_sums)
-        );
+    struct unmap_t {
+        size_t size;
 
-        blocks.emplace(1, 0, 0);
+        void operator()(const char *addr) const {
+            munmap(const_cast<char*>(addr), size);
+        }
+    };
+
+    static constexpr const uint32_t SNAPSHOT_VERSION = 3;
+    static constexpr const uint32_t SNAPSHOT_SIZES = sizeof(Height) | sizeof(Time) << 8
+                                                   | sizeof(Rate) << 16 | sizeof(Position) << 24;
+
+    fingerprint_t input{};
+    size_t resume_position{0};
+    bool rates_saved{false};
+    std::unique_ptr<const char, unmap_t> mapped_rates;
+
+    struct walk_t {
+        Height sum;
+        Position end;     // where the block created by the cut would begin
+        size_t remaining; // how many blocks the cut would leave untouched
+    };
+
+    template<class Input>
+    void prepare(Input &in) {
+        in >> n >> m;
+        read_rates(in);
     }
 
-    Height height_at(const Position &idx, const Time &day, const block_t &block) const {
-        return block.level + (day - block.since) * growth_rate[idx];
+    template<class Input>
+    void read_rates(Input &in) {
+        parse_rates(in);
+        prepare_rates();
+    }
+
+    template<class Input>
+    void parse_rates(Input &in) {
+        growth_rate.reserve(n + 1);
+        growth_rate.emplace_back(0);
+
+        for(Position i = 0; i < n; ++i) {
+            Rate rate;
+            in >> rate;
+            growth_rate.push_back(rate);
+        }
+    }
+
+    void prepare_rates() {
+        parallel_sort(growth_rate, threads);
+        parallel_partial_sum(growth_rate, partial_sums, threads);
+        rate_view = growth_rate;
+        sum_view = partial_sums;
+
+        search.build(rate_view);
+        blocks.emplace_back(1, 0, 0);
     }
 
     Height height_sum(const Position &left, const Position &right, const Time &day,
             const block_t &block, const Height &above = 0) const { // [left..right]
         static_assert(std::is_signed<Height>::value, "Height must be signed");
         auto base = static_cast<Height>((right - left + 1) * (block.level - above));
-        auto rates = static_cast<Height>(partial_sums[right] - partial_sums[left - 1]);
+        auto rates = sum_view[right] - sum_view[left - 1];
         return base + rates * (day - block.since);
     }
 
+    // height_at(idx) >= level <=> growth_rate[idx] >= ceil((level - block.level) / elapsed)
     Position first_not_less_than(const Height &level, const Time &day, const block_t &block,
             const Position &end) const {
-        Position left{block.begin}, right{end};
+        const auto elapsed = static_cast<Height>(day - block.since);
+        const auto missing = level - block.level;
 
-        while(left != right) {
-            auto mid = (left + right) / 2;
-            
-            if(height_at(mid, day, block) < level) {
-                left = mid + 1;
-            }
-            else {
-                right = mid;
-            }
-        }
+        if(elapsed == 0)
+            return missing <= 0 ? block.begin : end;
 
-        return left;
+        const auto threshold = missing >= 0
+            ? (missing + elapsed - 1) / elapsed
+            : -(-missing / elapsed);
+
+        if(threshold > static_cast<Height>(std::numeric_limits<Rate>::max()))
+            return end;
+        if(threshold <= static_cast<Height>(std::numeric_limits<Rate>::min()))
+            return block.begin;
+
+        return search.first_not_less_than(rate_view, static_cast<Rate>(threshold), block.begin, end);
     }
 
-    void read_line() {
+    template<class Input, class Output>
+    void read_line(Input &in, Output &out) {
         Time day;
         Height level;
-        std::cin >> day >> level;
+        in >> day >> level;
+        out << cut(day, level) << '\n';
+    }
 
-        Height sum{0};
-        auto end = n + 1;
+    walk_t walk(const Time &day, const Height &level) const {
+        walk_t result{0, n + 1, blocks.size()};
 
-        while(!blocks.empty()) {
-            const auto &block = blocks.top();
-            auto idx = first_not_less_than(level, day, block, end);
-            auto gain = height_sum(idx, end - 1, day, block, level);
-            sum += gain;
-            end = idx;
+        while(result.remaining > 0) {
+            const auto &block = blocks[result.remaining - 1];
+            auto idx = first_not_less_than(level, day, block, result.end);
+            auto gain = height_sum(idx, result.end - 1, day, block, level);
+            result.sum += gain;
+            result.end = idx;
 
             if(debug) {
                 std::cerr << day << " " << level << ": " << block << " -> "
@@ -125,23 +692,852 @@ class solver_t {
             }
 
             if(idx <= block.begin) {
-                blocks.pop();
+                --result.remaining;
             }
             else {
                 break;
             }
         }
 
-        if(end <= n) {
-            blocks.emplace(end, day, level);
+        return result;
+    }
+
+    Height cut(const Time &day, const Height &level) {
+        const auto result = walk(day, level);
+        const auto first = std::begin(blocks) + static_cast<std::ptrdiff_t>(result.remaining);
+
+        if(!checkpoints.empty()) {
+            journal.push_back({popped.size(), result.end <= n});
+            popped.insert(std::end(popped), first, std::end(blocks));
+        }
+
+        blocks.erase(first, std::end(blocks));
+
+        if(result.end <= n) {
+            blocks.emplace_back(result.end, day, level);
+        }
+
+        last_day = day;
+        return result.sum;
+    }
+
+    static uint64_t checksum(const char *data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+        uint64_t word;
+        for(; size >= sizeof(word); data += sizeof(word), size -= sizeof(word)) {
+            memcpy(&word, data, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ULL;
+            hash ^= hash >> 29;
+        }
+        for(; size > 0; ++data, --size)
+            hash = (hash ^ static_cast<unsigned char>(*data)) * 1099511628211ULL;
+        return hash;
+    }
+
+    static bool write_all(int fd, const void *data, size_t size) {
+        const auto *ptr = static_cast<const char*>(data);
+        while(size > 0) {
+            const auto written = ::write(fd, ptr, size);
+            if(written < 0) {
+                if(errno == EINTR)
+                    continue;
+                return false;
+            }
+            ptr += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    static size_t aligned(size_t size) {
+        return (size + 7) / 8 * 8;
+    }
+
+    static fingerprint_t identify(int fd) {
+        fingerprint_t result{};
+        struct stat st;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            result.device = st.st_dev;
+            result.inode = st.st_ino;
+            result.size = static_cast<uint64_t>(st.st_size);
+            result.modified = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        }
+        return result;
+    }
+
+    bool same_input(const fingerprint_t &other) const {
+        return memcmp(&input, &other, sizeof(input)) == 0;
+    }
+
+    // Written to a temporary file first, so a crash never leaves a torn file.
+    static bool write_file(const std::string &path, std::initializer_list<std::pair<const void*, size_t>> parts) {
+        const auto temporary = path + ".tmp";
+        const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = fd >= 0;
+        for(const auto &part: parts)
+            ok = ok && write_all(fd, part.first, part.second);
+        ok = ok && fsync(fd) == 0;
+
+        if(fd >= 0)
+            close(fd);
+
+        if(!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+            perror(path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // The rates only on the first save, the state every time.
+    void save(const char *path, size_t position) {
+        static_assert(std::is_trivially_copyable<block_t>::value, "block_t must be trivially copyable");
+        static_assert(sizeof(rates_header_t) % 8 == 0, "the rates must stay aligned");
+
+        if(!rates_saved) {
+            rates_header_t header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, "SIAR", 4);
+            header.version = SNAPSHOT_VERSION;
+            header.sizes = SNAPSHOT_SIZES;
+            header.n = n;
+            header.input = input;
+
+            static const char padding[8]{};
+            const auto rates_size = rate_view.size() * sizeof(Rate);
+            rates_saved = write_file(std::string{path} + ".rates", {
+                {&header, sizeof(header)},
+                {rate_view.data(), rates_size},
+                {padding, aligned(rates_size) - rates_size},
+                {sum_view.data(), sum_view.size() * sizeof(Height)}});
+            if(!rates_saved)
+                return;
+        }
+
+        state_header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "SIA", 4);
+        header.version = SNAPSHOT_VERSION;
+        header.sizes = SNAPSHOT_SIZES;
+        header.m = m;
+        header.n = n;
+        header.blocks = blocks.size();
+        header.processed = processed;
+        header.last_day = last_day;
+        header.position = position;
+        header.input = input;
+
+        const auto blocks_size = blocks.size() * sizeof(block_t);
+        const auto hash = checksum(reinterpret_cast<const char*>(&header), sizeof(header));
+        header.checksum = checksum(reinterpret_cast<const char*>(blocks.data()), blocks_size, hash);
+
+        write_file(path, {{&header, sizeof(header)}, {blocks.data(), blocks_size}});
+    }
+
+    // Loads the snapshot if it is intact and matches the input already read.
+    bool restore(const char *path) {
+        const int fd = open(path, O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        const void *addr = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(state_header_t))
+            addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if(addr == MAP_FAILED) {
+            std::cerr << path << ": not a snapshot, starting from scratch" << std::endl;
+            return false;
+        }
+
+        const auto size = static_cast<size_t>(st.st_size);
+        const bool ok = restore_rates(std::string{path} + ".rates")
+                     && restore_state(static_cast<const char*>(addr), size);
+        munmap(const_cast<void*>(addr), size);
+
+        if(!ok) {
+            mapped_rates.reset();
+            rate_view = {};
+            sum_view = {};
+            std::cerr << path << ": snapshot does not match, starting from scratch" << std::endl;
+        }
+        return ok;
+    }
+
+    // Maps the rates and serves them from there, trusting the header: the
+    // file was fsynced before it was renamed into place, and checksumming
+    // it would cost as much as sorting again.
+    bool restore_rates(const std::string &path) {
+        const auto rates_size = aligned((n + 1) * sizeof(Rate));
+        const auto size = sizeof(rates_header_t) + rates_size + (n + 1) * sizeof(Height);
+
+        const int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        const void *addr = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size)
+            addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if(addr == MAP_FAILED)
+            return false;
+
+        const auto data = static_cast<const char*>(addr);
+        mapped_rates = std::unique_ptr<const char, unmap_t>{data, unmap_t{size}};
+
+        rates_header_t header;
+        memcpy(&header, data, sizeof(header));
+        if(memcmp(header.magic, "SIAR", 4) != 0 || header.version != SNAPSHOT_VERSION
+                || header.sizes != SNAPSHOT_SIZES || header.n != n || !same_input(header.input))
+            return false;
+
+        rate_view = {reinterpret_cast<const Rate*>(data + sizeof(header)), n + 1};
+        sum_view = {reinterpret_cast<const Height*>(data + sizeof(header) + rates_size), n + 1};
+        rates_saved = true;
+        return true;
+    }
+
+    bool restore_state(const char *data, size_t size) {
+        state_header_t header;
+        memcpy(&header, data, sizeof(header));
+
+        if(memcmp(header.magic, "SIA", 4) != 0 || header.version != SNAPSHOT_VERSION
+                || header.sizes != SNAPSHOT_SIZES || header.n != n || header.m != m
+                || header.processed < 0 || header.processed > m
+                || header.position > input.size || !same_input(header.input))
+            return false;
+
+        const auto blocks_size = header.blocks * sizeof(block_t);
+        if(size != sizeof(header) + blocks_size)
+            return false;
+
+        const auto expected = header.checksum;
+        header.checksum = 0;
+        const auto hash = checksum(reinterpret_cast<const char*>(&header), sizeof(header));
+        if(checksum(data + sizeof(header), blocks_size, hash) != expected)
+            return false;
+
+        blocks.clear();
+        blocks.reserve(header.blocks);
+        for(size_t i = 0; i < header.blocks; ++i) {
+            block_t block{0, 0, 0};
+            memcpy(&block, data + sizeof(header) + i * sizeof(block_t), sizeof(block_t));
+            blocks.push_back(block);
+        }
+
+        std::vector<Rate>{}.swap(growth_rate);
+        search.build(rate_view);
+        processed = static_cast<int>(header.processed);
+        last_day = header.last_day;
+        resume_position = header.position;
+        return true;
+    }
+
+    static void report_latencies(std::vector<long long> &&latencies) {
+        if(latencies.empty())
+            return;
+
+        std::sort(std::begin(latencies), std::end(latencies));
+        const auto total = std::accumulate(std::begin(latencies), std::end(latencies), 0LL);
+        const auto percentile = [&latencies](size_t p) {
+            return latencies[(latencies.size() - 1) * p / 100];
+        };
+
+        std::cerr << latencies.size() << " queries, latency [ns]: avg "
+                  << total / static_cast<long long>(latencies.size())
+                  << ", p50 " << percentile(50) << ", p99 " << percentile(99)
+                  << ", max " << latencies.back() << std::endl;
+    }
+};
+
+// The same field, but plants can be added and removed between cuts.
+//
+// Plants are kept in a treap ordered by rate. Heights are non-decreasing in
+// that order, so a cut splits off the suffix of plants not lower than the
+// level and tags it with "at level L since day d". A new plant gets the height
+// it would have had if it had been there from the start:
+//     day * rate + min(0, min over cuts (level_j - day_j * rate)),
+// the minimum being taken from the lower envelope of the cut lines.
+template<class Height = long long, class Time = long long, class Rate = long long>
+class dynamic_field_t {
+    public:
+    dynamic_field_t()
+    : root{NIL}
+    , last_day{0}
+    , random{2015}
+    { }
+
+    template<class Input, class Output>
+    void solve(Input &in, Output &out) && {
+        size_t n, m;
+        in >> n >> m;
+
+        for(size_t i = 0; i < n; ++i) {
+            Rate rate;
+            in >> rate;
+            insert(rate);
+        }
+
+        std::string op;
+        for(size_t i = 0; i < m && in >> op; ++i) {
+            Rate rate;
+            if(op == "+") {
+                in >> rate;
+                insert(rate);
+            }
+            else if(op == "-") {
+                in >> rate;
+                if(!remove(rate))
+                    out << "NIE\n";
+            }
+            else {
+                // A day before the last cut would break the envelope (its
+                // slopes must decrease), so it is answered with NIE like a
+                // token that is not a number.
+                std::string level_token;
+                in >> level_token;
+                long long day, level;
+                if(!parse_number(op, day) || !parse_number(level_token, level)
+                        || static_cast<Time>(day) < last_day)
+                    out << "NIE\n";
+                else
+                    out << cut(static_cast<Time>(day), static_cast<Height>(level)) << '\n';
+            }
+        }
+    }
+
+    void insert(const Rate &rate) {
+        const auto offset = envelope_at(rate);
+        const node_t plant{rate, static_cast<Height>(last_day * rate + std::min<Height>(0, offset)),
+                           last_day, static_cast<unsigned>(random())};
+
+        index_t node;
+        if(free_nodes.empty()) {
+            node = nodes.size();
+            nodes.push_back(plant);
+        }
+        else {
+            node = free_nodes.back();
+            free_nodes.pop_back();
+            nodes[node] = plant;
+        }
+
+        index_t less, rest;
+        split_by_rate(root, rate, less, rest);
+        root = merge(merge(less, node), rest);
+    }
+
+    bool remove(const Rate &rate) {
+        index_t less, rest, victim;
+        split_by_rate(root, rate, less, rest);
+        split_first(rest, victim, rest);
+
+        const bool found = victim != NIL && nodes[victim].rate == rate;
+        if(found)
+            free_nodes.push_back(victim);
+        else
+            rest = merge(victim, rest);
+
+        root = merge(less, rest);
+        return found;
+    }
+
+    Height cut(const Time &day, const Height &level) {
+        index_t lower, higher;
+        split_by_height(root, day, level, lower, higher);
+
+        Height gain{0};
+        if(higher != NIL) {
+            const auto &node = nodes[higher];
+            gain = sum_at(higher, day) - static_cast<Height>(node.count) * level;
+            assign(higher, level, day);
         }
 
-        std::cout << sum << "\n";
+        root = merge(lower, higher);
+        add_line(day, level);
+        last_day = day;
+        return gain;
+    }
+
+    private:
+    using index_t = size_t;
+    static constexpr const index_t NIL = -1;
+
+    struct node_t {
+        Rate rate;
+        Height level;
+        Time since;
+        unsigned priority;
+        index_t left, right;
+
+        size_t count;
+        Height rate_sum;
+        Height height_sum; // as of day stamp
+        Time stamp;
+        bool tagged;
+
+        node_t(const Rate &rate, const Height &level, const Time &since, unsigned priority)
+        : rate{rate}
+        , level{level}
+        , since{since}
+        , priority{priority}
+        , left{NIL}
+        , right{NIL}
+        , count{1}
+        , rate_sum{rate}
+        , height_sum{level}
+        , stamp{since}
+        , tagged{false}
+        { }
+    };
+
+    struct line_t {
+        Time day;
+        Height level;
+    };
+
+    std::vector<node_t> nodes;
+    std::vector<index_t> free_nodes;
+    index_t root;
+    Time last_day;
+    std::vector<line_t> envelope; // level - day * rate, decreasing slopes
+    std::mt19937 random;
+
+    Height height_at(index_t idx, const Time &day) const {
+        const auto &node = nodes[idx];
+        return node.level + (day - node.since) * node.rate;
+    }
+
+    Height sum_at(index_t idx, const Time &day) const {
+        if(idx == NIL)
+            return 0;
+        const auto &node = nodes[idx];
+        return node.height_sum + (day - node.stamp) * node.rate_sum;
+    }
+
+    void assign(index_t idx, const Height &level, const Time &day) {
+        auto &node = nodes[idx];
+        node.level = level;
+        node.since = day;
+        node.height_sum = static_cast<Height>(node.count) * level;
+        node.stamp = day;
+        node.tagged = true;
+    }
+
+    void push(index_t idx) {
+        auto &node = nodes[idx];
+        if(!node.tagged)
+            return;
+
+        for(const auto child: {node.left, node.right})
+            if(child != NIL)
+                assign(child, node.level, node.since);
+        node.tagged = false;
+    }
+
+    void pull(index_t idx) {
+        auto &node = nodes[idx];
+        const auto day = std::max({node.since, stamp_of(node.left), stamp_of(node.right)});
+
+        node.count = 1 + count_of(node.left) + count_of(node.right);
+        node.rate_sum = node.rate + rate_sum_of(node.left) + rate_sum_of(node.right);
+        node.height_sum = height_at(idx, day) + sum_at(node.left, day) + sum_at(node.right, day);
+        node.stamp = day;
+    }
+
+    size_t count_of(index_t idx) const {
+        return idx == NIL ? 0 : nodes[idx].count;
+    }
+
+    Height rate_sum_of(index_t idx) const {
+        return idx == NIL ? 0 : nodes[idx].rate_sum;
+    }
+
+    Time stamp_of(index_t idx) const {
+        return idx == NIL ? 0 : nodes[idx].stamp;
+    }
+
+    index_t merge(index_t lhs, index_t rhs) {
+        if(lhs == NIL)
+            return rhs;
+        if(rhs == NIL)
+            return lhs;
+
+        if(nodes[lhs].priority > nodes[rhs].priority) {
+            push(lhs);
+            nodes[lhs].right = merge(nodes[lhs].right, rhs);
+            pull(lhs);
+            return lhs;
+        }
+        else {
+            push(rhs);
+            nodes[rhs].left = merge(lhs, nodes[rhs].left);
+            pull(rhs);
+            return rhs;
+        }
+    }
+
+    // Splits idx into the plants for which go_right is false and the rest;
+    // go_right must be monotone in the treap order.
+    template<class Pred>
+    void split(index_t idx, Pred &&go_right, index_t &lhs, index_t &rhs) {
+        if(idx == NIL) {
+            lhs = rhs = NIL;
+            return;
+        }
+
+        push(idx);
+        if(go_right(idx)) {
+            split(nodes[idx].left, go_right, lhs, nodes[idx].left);
+            rhs = idx;
+        }
+        else {
+            split(nodes[idx].right, go_right, nodes[idx].right, rhs);
+            lhs = idx;
+        }
+        pull(idx);
+    }
+
+    void split_by_rate(index_t idx, const Rate &rate, index_t &lhs, index_t &rhs) {
+        split(idx, [this, &rate](index_t node) { return nodes[node].rate >= rate; }, lhs, rhs);
+    }
+
+    void split_by_height(index_t idx, const Time &day, const Height &level, index_t &lhs, index_t &rhs) {
+        split(idx, [this, &day, &level](index_t node) { return height_at(node, day) >= level; }, lhs, rhs);
+    }
+
+    void split_first(index_t idx, index_t &first, index_t &rest) {
+        size_t before = 0; // plants known to precede the current node
+        split(idx, [this, &before](index_t node) {
+            if(before + count_of(nodes[node].left) >= 1)
+                return true;
+            before += count_of(nodes[node].left) + 1;
+            return false;
+        }, first, rest);
+    }
+
+    static __int128_t cross(const line_t &a, const line_t &b, const line_t &c) {
+        // does b never go strictly below both a and c (slopes -a.day > -b.day > -c.day)?
+        return static_cast<__int128_t>(c.level - a.level) * (b.day - a.day)
+             - static_cast<__int128_t>(b.level - a.level) * (c.day - a.day);
+    }
+
+    void add_line(const Time &day, const Height &level) {
+        const line_t line{day, level};
+
+        if(!envelope.empty() && envelope.back().day == day) {
+            if(envelope.back().level <= level)
+                return;
+            envelope.pop_back();
+        }
+
+        while(envelope.size() >= 2 && cross(envelope[envelope.size() - 2], envelope.back(), line) <= 0)
+            envelope.pop_back();
+        envelope.push_back(line);
+    }
+
+    Height envelope_at(const Rate &rate) const {
+        const auto value = [&rate](const line_t &line) { return line.level - line.day * rate; };
+
+        size_t left = 0, right = envelope.size();
+        if(left == right)
+            return 0;
+
+        while(right - left > 1) {
+            auto mid = (left + right) / 2;
+            if(value(envelope[mid]) <= value(envelope[mid - 1]))
+                left = mid;
+            else
+                right = mid;
+        }
+
+        return value(envelope[left]);
     }
 };
 
+template<class Solver>
+int serve_socket(Solver &solver, const char *path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if(strlen(path) >= sizeof(addr.sun_path)) {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+
+    if(listener < 0
+            || bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0
+            || listen(listener, 16) < 0) {
+        perror(path);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    while(true) {
+        const int client = accept(listener, nullptr, nullptr);
+        if(client < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("accept");
+            return 1;
+        }
+
+        {
+            fastio::reader_t in{client};
+            fastio::writer_t out{client};
+            solver.serve(in, out);
+        }
+        close(client);
+    }
+}
+
+// Reads n rates into rates, preceded by a 0.
+template<class Rate, class Input>
+void read_rates(Input &in, size_t n, std::vector<Rate> &rates) {
+    rates.reserve(n + 1);
+    rates.push_back(0);
+
+    for(size_t i = 0; i < n; ++i) {
+        Rate rate;
+        in >> rate;
+        rates.push_back(rate);
+    }
+}
+
+// Reads n rates into narrow, preceded by a 0. Once one of them does not fit,
+// they all end up in wide and false is returned. narrow is freed before wide
+// is allocated: a mapped input is simply read again, otherwise only the
+// rates read so far are kept (at 4 B each) while they are widened.
+template<class Narrow, class Wide, class Input>
+bool read_rates(Input &in, size_t n, std::vector<Narrow> &narrow, std::vector<Wide> &wide) {
+    const auto start = in.position();
+    narrow.reserve(n + 1);
+    narrow.push_back(0);
+
+    for(size_t i = 0; i < n; ++i) {
+        Wide rate;
+        in >> rate;
+
+        if(rate < std::numeric_limits<Narrow>::min() || rate > std::numeric_limits<Narrow>::max()) {
+            if(in.seek(start)) {
+                std::vector<Narrow>{}.swap(narrow);
+                read_rates(in, n, wide);
+                return false;
+            }
+
+            std::vector<Narrow>(std::begin(narrow), std::end(narrow)).swap(narrow);
+            wide.reserve(n + 1);
+            wide.assign(std::begin(narrow), std::end(narrow));
+            std::vector<Narrow>{}.swap(narrow);
+
+            wide.push_back(rate);
+            for(++i; i < n; ++i) {
+                in >> rate;
+                wide.push_back(rate);
+            }
+            return false;
+        }
+
+        narrow.push_back(static_cast<Narrow>(rate));
+    }
+
+    return true;
+}
+
+// The contest format, with 32-bit rates and positions when the input allows.
+// Heights, days and prefix sums stay 64-bit. With report set, only the
+// memory taken by the rates, their prefix sums and a block is printed.
+template<class Input, class Output>
+void solve_narrowest(Input &in, Output &out, unsigned threads, bool report = false) {
+    using wide_t = solver_t<long long, long long, long long, size_t>;
+    using narrow_t = solver_t<long long, long long, int32_t, uint32_t>;
+
+    size_t n;
+    int m;
+    in >> n >> m;
+
+    std::vector<int32_t> narrow;
+    std::vector<long long> wide;
+    bool fits = n < std::numeric_limits<uint32_t>::max();
+    if(fits)
+        fits = read_rates(in, n, narrow, wide);
+    else
+        read_rates(in, n, wide);
+
+    if(report) {
+        const auto wide_size = (n + 1) * (sizeof(long long) + sizeof(long long));
+        const auto narrow_size = (n + 1) * (sizeof(int32_t) + sizeof(long long));
+        out << "n = " << n << ", narrow types " << (fits ? "used" : "not usable") << '\n'
+            << "rates and prefix sums: " << wide_size << " B wide, " << narrow_size << " B narrow\n"
+            << "one block: " << wide_t::block_size() << " B wide, " << narrow_t::block_size() << " B narrow\n";
+        return;
+    }
+
+    if(fits)
+        narrow_t{threads}.solve(in, out, static_cast<uint32_t>(n), m, std::move(narrow));
+    else
+        wide_t{threads}.solve(in, out, n, m, std::move(wide));
+}
+
+template<class Search, class Rate, class Position>
+void bench_search_engine(const char *name, const std::vector<Rate> &rates,
+        const std::vector<Rate> &thresholds, Position &checksum) {
+    using clock = std::chrono::steady_clock;
+
+    Search search;
+    search.build(rates);
+
+    const auto start = clock::now();
+    Position sum{0};
+    for(const auto &threshold: thresholds)
+        sum += search.first_not_less_than(rates, threshold, 1, rates.size());
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+
+    std::cout << name << ": " << static_cast<double>(thresholds.size()) / elapsed.count() / 1e6
+              << " Mqueries/s" << std::endl;
+
+    if(checksum != 0 && checksum != sum)
+        std::cout << "\tresults differ!" << std::endl;
+    checksum = sum;
+}
+
+// Query throughput of the search engines on n random rates.
+void bench_search(size_t n, size_t queries) {
+    using rate_t = long long;
+    std::mt19937_64 gen{2015};
+    std::uniform_int_distribution<rate_t> dist{1, 1000000000};
+
+    std::vector<rate_t> rates(n + 1, 0);
+    std::generate(std::begin(rates) + 1, std::end(rates), [&] { return dist(gen); });
+    std::sort(std::begin(rates), std::end(rates));
+
+    std::vector<rate_t> thresholds(queries);
+    std::generate(std::begin(thresholds), std::end(thresholds), [&] { return dist(gen); });
+
+    std::cout << "n = " << n << ", " << queries << " queries" << std::endl;
+    size_t checksum{0};
+    bench_search_engine<binary_search_t<rate_t, size_t>>("binary", rates, thresholds, checksum);
+    bench_search_engine<eytzinger_search_t<rate_t, size_t>>("eytzinger", rates, thresholds, checksum);
+}
+
+// Sorting and prefix sums of n random rates, sequential and with 1, 2, 4...
+// up to max_threads threads.
+void bench_prepare(size_t n, unsigned max_threads) {
+    using rate_t = long long;
+    using clock = std::chrono::steady_clock;
+
+    std::mt19937_64 gen{2015};
+    std::uniform_int_distribution<rate_t> dist{1, 1000000000};
+    std::vector<rate_t> input(n);
+    std::generate(std::begin(input), std::end(input), [&] { return dist(gen); });
+
+    const auto measure = [&input](const char *name, unsigned threads,
+            const std::function<void(std::vector<rate_t>&, std::vector<rate_t>&)> &prepare) {
+        auto rates = input;
+        std::vector<rate_t> sums;
+
+        const auto start = clock::now();
+        prepare(rates, sums);
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+
+        std::cout << name << " " << threads << ": " << elapsed.count() << " s" << std::endl;
+        if(!std::is_sorted(std::begin(rates), std::end(rates)))
+            std::cout << "\tnot sorted!" << std::endl;
+    };
+
+    std::cout << "n = " << n << std::endl;
+    measure("std::sort + std::partial_sum", 1, [](std::vector<rate_t> &rates, std::vector<rate_t> &sums) {
+        std::sort(std::begin(rates), std::end(rates));
+        std::partial_sum(std::begin(rates), std::end(rates), std::back_inserter(sums));
+    });
+
+    for(unsigned threads = 1; threads <= std::max(1u, max_threads); threads *= 2)
+        measure("radix sort + prefix sum", threads, [threads](std::vector<rate_t> &rates, std::vector<rate_t> &sums) {
+            parallel_sort(rates, threads);
+            parallel_partial_sum(rates, sums, threads);
+        });
+}
+
+// Usage: sia                  - the contest format on stdin
+//        sia --serve          - load the field, then answer queries from stdin
+//        sia --serve <socket> - load the field from stdin, then answer queries
+//                               sent over a Unix domain socket
+//        sia --what-if [threads]
+//                             - the contest format, followed by hypothetical
+//                               "day level" cuts answered in parallel
+//        sia --snapshot <file> [every]
+//                             - the contest format, saving the state to file
+//                               (and the sorted rates to file.rates, once)
+//                               every that many queries and resuming from it
+//                               if it is there
+//        sia --dynamic        - like the contest format, but each of the m
+//                               lines may also be "+ rate" or "- rate"
+//        sia --memory-report  - what narrowing the types saves on the input
+//        sia --bench-search [n] [queries]
+//        sia --threads <k> --bench-prepare [n]
+//
+// --threads <k> in front of any of the above sets the number of threads used
+// for sorting the rates and computing their prefix sums.
+int main(int argc, char **argv) {
+    unsigned threads = 1;
+    if(argc > 2 && std::string{argv[1]} == "--threads") {
+        threads = static_cast<unsigned>(std::stoul(argv[2]));
+        argc -= 2;
+        argv += 2;
+    }
+
+    if(argc > 1 && std::string{argv[1]} == "--bench-search") {
+        bench_search(argc > 2 ? std::stoul(argv[2]) : 1 << 24,
+                     argc > 3 ? std::stoul(argv[3]) : 1 << 22);
+        return 0;
+    }
+
+    if(argc > 1 && std::string{argv[1]} == "--bench-prepare") {
+        bench_prepare(argc > 2 ? std::stoul(argv[2]) : 1 << 26, threads);
+        return 0;
+    }
+
+    int every = 1 << 20;
+    if(argc > 3 && std::string{argv[1]} == "--snapshot") {
+        every = std::atoi(argv[3]);
+        if(every <= 0) {
+            std::cerr << "--snapshot: every must be a positive number of queries" << std::endl;
+            return 1;
+        }
+    }
+
+    fastio::reader_t in;
+
+    if(argc > 1 && std::string{argv[1]} == "--serve") {
+        solver_t<> solver{threads};
+        solver.load(in);
+
+        if(argc > 2)
+            return serve_socket(solver, argv[2]);
+
+        fastio::writer_t out;
+        solver.serve(in, out);
+        return 0;
+    }
+
+    fastio::writer_t out;
 
-int main() {
-    std::ios_base::sync_with_stdio(false);
-    solver_t<>{}.solve();
+    if(argc > 2 && std::string{argv[1]} == "--snapshot")
+        solver_t<>{threads}.solve(in, out, argv[2], every);
+    else if(argc > 1 && std::string{argv[1]} == "--dynamic")
+        dynamic_field_t<>{}.solve(in, out);
+    else if(argc > 1 && std::string{argv[1]} == "--what-if")
+        solver_t<>{threads}.what_if(in, out, argc > 2 ? static_cast<unsigned>(std::stoul(argv[2]))
+                                                      : std::max(1u, std::thread::hardware_concurrency()));
+    else if(argc > 1 && std::string{argv[1]} == "--memory-report")
+        solve_narrowest(in, out, threads, true);
+    else
+        solve_narrowest(in, out, threads);
 }
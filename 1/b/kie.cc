@@ -1,31 +1,282 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "fastio.h"
+
+// The largest even sum: the total, or the total without its smallest odd value.
 template<class T, class Acc>
-void solve(size_t n) {
+struct reduction_t {
     Acc s{0};
     T min_odd{std::numeric_limits<T>::max()};
-    using std::min;
+    size_t count{0};
 
-    for(size_t i = 0; i < n; ++i) {
-        T val;
-        std::cin >> val;
+    void add(const T &val) {
+        using std::min;
         s += val;
         if(val % 2 == 1)
             min_odd = min(val, min_odd);
+        ++count;
+    }
+
+    // Branch-free, so that the compiler vectorizes it.
+    void add(const T *values, size_t size) {
+        Acc batch_s{0};
+        T batch_min_odd{std::numeric_limits<T>::max()};
+        for(size_t i = 0; i < size; ++i) {
+            batch_s += values[i];
+            const T candidate = values[i] % 2 == 1 ? values[i] : std::numeric_limits<T>::max();
+            batch_min_odd = candidate < batch_min_odd ? candidate : batch_min_odd;
+        }
+
+        s += batch_s;
+        min_odd = std::min(min_odd, batch_min_odd);
+        count += size;
+    }
+
+    void merge(const reduction_t &other) {
+        using std::min;
+        s += other.s;
+        min_odd = min(min_odd, other.min_odd);
+        count += other.count;
     }
 
-    if(s % 2 == 0)
-        std::cout << s << std::endl;
-    else if(min_odd != s && min_odd != std::numeric_limits<T>::max())
-        std::cout << s - min_odd << std::endl;
-    else
-        std::cout << "NIESTETY" << std::endl;
+    friend std::ostream& operator<<(std::ostream &str, const reduction_t &r) {
+        if(r.s % 2 == 0)
+            return str << r.s << std::endl;
+        else if(r.min_odd != r.s && r.min_odd != std::numeric_limits<T>::max())
+            return str << r.s - r.min_odd << std::endl;
+        else
+            return str << "NIESTETY" << std::endl;
+    }
+};
+
+// The largest sum divisible by k, for non-negative values: the total without
+// the cheapest subset whose sum has the total's residue. removal[r] is the
+// smallest sum of a subset with residue r seen so far, so the state is O(k)
+// however long the input is.
+template<class T, class Acc>
+class residue_reduction_t {
+    public:
+    explicit residue_reduction_t(size_t k)
+    : s{0}
+    , count{0}
+    , k{k}
+    , removal(k, INF)
+    , scratch(k)
+    , worst{INF}
+    {
+        removal[0] = 0;
+    }
+
+    Acc s;
+    size_t count;
+
+    // removal'[r] = min(removal[r], removal[r - val] + val), in two contiguous
+    // runs so that it vectorizes. Values not smaller than every finite entry
+    // cannot improve anything and are only counted.
+    void add(const T &val) {
+        s += val;
+        ++count;
+
+        if(val >= worst)
+            return;
+
+        const auto shift = static_cast<size_t>(val) % k;
+        const Acc v = val;
+        std::copy(std::begin(removal), std::end(removal), std::begin(scratch));
+
+        for(size_t i = shift; i < k; ++i)
+            removal[i] = std::min(removal[i], scratch[i - shift] + v);
+        for(size_t i = 0; i < shift; ++i)
+            removal[i] = std::min(removal[i], scratch[i + k - shift] + v);
+
+        worst = *std::max_element(std::begin(removal), std::end(removal));
+    }
+
+    void add(const T *values, size_t size) {
+        for(size_t i = 0; i < size; ++i)
+            add(values[i]);
+    }
+
+    // (min, +) convolution of the two residue arrays, O(k^2).
+    void merge(const residue_reduction_t &other) {
+        std::fill(std::begin(scratch), std::end(scratch), INF);
+        for(size_t i = 0; i < k; ++i) {
+            if(removal[i] == INF)
+                continue;
+            for(size_t j = 0; j < k; ++j) {
+                auto &target = scratch[i + j < k ? i + j : i + j - k];
+                target = std::min(target, removal[i] + other.removal[j]);
+            }
+        }
+
+        removal.swap(scratch);
+        worst = *std::max_element(std::begin(removal), std::end(removal));
+        s += other.s;
+        count += other.count;
+    }
+
+    friend std::ostream& operator<<(std::ostream &str, const residue_reduction_t &r) {
+        const auto residue = static_cast<size_t>(r.s % static_cast<Acc>(r.k));
+        if(residue == 0)
+            return str << r.s << std::endl;
+        else if(r.removal[residue] != r.s && r.removal[residue] < INF)
+            return str << r.s - r.removal[residue] << std::endl;
+        else
+            return str << "NIESTETY" << std::endl;
+    }
+
+    private:
+    static constexpr const Acc INF = std::numeric_limits<Acc>::max() / 2;
+
+    size_t k;
+    std::vector<Acc> removal, scratch;
+    Acc worst;
+};
+
+template<class T, class Acc>
+constexpr const Acc residue_reduction_t<T, Acc>::INF;
+
+template<class T, class Reduction>
+void solve(size_t n, Reduction r) {
+    for(size_t i = 0; i < n; ++i) {
+        T val;
+        std::cin >> val;
+        r.add(val);
+    }
+
+    std::cout << r;
+}
+
+// Parses whitespace-separated numbers from [begin, end) into batches and
+// folds them into r.
+template<class T, class Reduction>
+Reduction reduce(const char *begin, const char *end, Reduction r) {
+    static constexpr const size_t BATCH = 1024;
+    T batch[BATCH];
+
+    size_t size = 0;
+    const char *cur = begin;
+    while(true) {
+        while(cur != end && (*cur < '0' || *cur > '9') && *cur != '-')
+            ++cur;
+        if(cur == end)
+            break;
+
+        const bool negative = *cur == '-';
+        if(negative)
+            ++cur;
+
+        T val = 0;
+        while(cur != end && '0' <= *cur && *cur <= '9')
+            val = static_cast<T>(val * 10 + (*cur++ - '0'));
+
+        batch[size++] = negative ? static_cast<T>(-val) : val;
+        if(size == BATCH) {
+            r.add(batch, size);
+            size = 0;
+        }
+    }
+
+    r.add(batch, size);
+    return r;
+}
+
+// Splits the mapped input after the header into one chunk per thread, each
+// chunk boundary moved forward to the next whitespace. Returns false (and
+// prints nothing) if the input is not a regular file or does not hold
+// exactly n numbers.
+template<class T, class Reduction>
+bool solve_parallel(unsigned threads, const Reduction &empty) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+
+    const fastio::mapping_t input{0};
+    if(!input)
+        return false;
+
+    const char *cur = input.begin(), *end = input.end();
+    while(cur != end && (*cur < '0' || *cur > '9'))
+        ++cur;
+
+    size_t n = 0;
+    while(cur != end && '0' <= *cur && *cur <= '9')
+        n = n * 10 + static_cast<size_t>(*cur++ - '0');
+
+    const auto size = static_cast<size_t>(end - cur);
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, size)));
+
+    std::vector<const char*> bounds{cur};
+    for(unsigned thread = 1; thread < threads; ++thread) {
+        auto bound = std::max(bounds.back(), cur + size * thread / threads);
+        while(bound != end && *bound != ' ' && *bound != '\n' && *bound != '\t' && *bound != '\r')
+            ++bound;
+        bounds.push_back(bound);
+    }
+    bounds.push_back(end);
+
+    std::vector<Reduction> partial(threads, empty);
+    std::vector<std::thread> workers;
+    for(unsigned thread = 0; thread < threads; ++thread)
+        workers.emplace_back([&partial, &bounds, &empty, thread] {
+            partial[thread] = reduce<T>(bounds[thread], bounds[thread + 1], empty);
+        });
+
+    for(auto &worker: workers)
+        worker.join();
+
+    auto r = empty;
+    for(const auto &p: partial)
+        r.merge(p);
+
+    if(r.count != n)
+        return false;
+
+    std::cout << r;
+
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    const auto bytes = static_cast<double>(input.end() - input.begin());
+    std::cerr << bytes / 1e9 << " GB in " << elapsed.count() << " s: "
+              << bytes / 1e9 / elapsed.count() << " GB/s" << std::endl;
+    return true;
 }
 
-int main() {
+template<class T, class Reduction>
+void run(int argc, char **argv, const Reduction &empty) {
+    if(argc > 1 && std::string{argv[1]} == "--parallel") {
+        const auto threads = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2]))
+                                      : std::max(1u, std::thread::hardware_concurrency());
+        if(solve_parallel<T>(threads, empty))
+            return;
+    }
+
     std::ios_base::sync_with_stdio(false);
     size_t n;
     std::cin >> n;
-    solve<int, long long>(n);
+    solve<T>(n, empty);
+}
+
+// Usage: kie [--mod k] [--parallel [threads]]
+//   --mod k       - the largest sum divisible by k instead of 2
+//   --parallel    - the input must be a regular file (falls back otherwise)
+int main(int argc, char **argv) {
+    if(argc > 2 && std::string{argv[1]} == "--mod") {
+        char *parsed;
+        errno = 0;
+        const auto k = strtoul(argv[2], &parsed, 10);
+        if(errno != 0 || *parsed != '\0' || argv[2][0] == '-' || k < 1) {
+            std::cerr << "--mod: k must be a positive number" << std::endl;
+            return 1;
+        }
+        run<int>(argc - 2, argv + 2, residue_reduction_t<int, long long>{k});
+    } else {
+        run<int>(argc, argv, reduction_t<int, long long>{});
+    }
 }
@@ -1,8 +1,19 @@
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cinttypes>
 #include <cstdint>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 #include <cassert>
 
 #ifdef TESTS
@@ -112,89 +123,753 @@ T multiply(T lhs, T rhs, T mod) {
     return result;
 }
 
+// Reducers: multiplication modulo a fixed mod, for values already below it.
+
+// The plain way, through multiply(lhs, rhs, mod).
 template<class T>
-__attribute__((pure))
-mat2x2<T> multiply(const mat2x2<T> &lhs, const mat2x2<T> &rhs, const T mod) {
-    auto result = defs<T>::zero;
+struct modulo_t {
+    using value_type = T;
 
-    for(int i = 0; i < 2; ++i)
-        for(int k = 0; k < 2; ++k)
-            for(int j = 0; j < 2; ++j)
-                result[i][j] += multiply(lhs[i][k], rhs[k][j], mod);
+    explicit modulo_t(const T mod)
+    : mod{mod}
+    { }
+
+    T mod;
+
+    T operator()(const T lhs, const T rhs) const {
+        return multiply(lhs, rhs, mod);
+    }
+};
+
+// Barrett reduction: with k the bit length of mod and b the bit length of T,
+// x / mod is the high half of (x >> (k - 1)) * mu for mu = 2^(b + k - 1) / mod,
+// less by at most two, so the division becomes two multiplications. Needs the
+// doubled type and mod < 2^(b - 2), not a power of two, so that mu, x >> (k - 1)
+// and the remainder before the corrections fit into T.
+template<class T>
+struct barrett_t {
+    using value_type = T;
+    using U = typename doubled<T>::type;
+
+    explicit barrett_t(const T mod)
+    : mod{mod}
+    , shift{bit_length(mod) - 1}
+    , mu{static_cast<T>((static_cast<U>(1) << (std::numeric_limits<T>::digits + shift)) / mod)}
+    {
+        assert(mod > 2 && shift + 2 < std::numeric_limits<T>::digits && (mod & (mod - 1)) != 0);
+    }
+
+    T mod;
+
+    T operator()(const T lhs, const T rhs) const {
+        constexpr const int digits = std::numeric_limits<T>::digits;
+        const U product = static_cast<U>(lhs) * rhs;
+        const auto low = static_cast<T>(product), high = static_cast<T>(product >> digits);
+        const auto shifted = static_cast<T>(low >> shift | high << (digits - shift));
+        const auto quotient = static_cast<T>((static_cast<U>(shifted) * mu) >> digits);
+
+        T result = static_cast<T>(low - quotient * mod);
+        result = result >= mod ? result - mod : result;
+        return result >= mod ? result - mod : result;
+    }
+
+    private:
+    int shift; // k - 1
+    T mu;
+
+    static int bit_length(T value) {
+        int result = 0;
+        for(; value; value /= 2)
+            ++result;
+        return result;
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+// 128 x 128 -> 256-bit product from four 64 x 64 -> 128-bit ones.
+inline void multiply_wide(const __uint128_t lhs, const __uint128_t rhs, __uint128_t &high, __uint128_t &low) {
+    const auto lhs_low = static_cast<uint64_t>(lhs), lhs_high = static_cast<uint64_t>(lhs >> 64);
+    const auto rhs_low = static_cast<uint64_t>(rhs), rhs_high = static_cast<uint64_t>(rhs >> 64);
+
+    const __uint128_t low_low = static_cast<__uint128_t>(lhs_low) * rhs_low;
+    const __uint128_t low_high = static_cast<__uint128_t>(lhs_low) * rhs_high;
+    const __uint128_t high_low = static_cast<__uint128_t>(lhs_high) * rhs_low;
+    const __uint128_t high_high = static_cast<__uint128_t>(lhs_high) * rhs_high;
+
+    const __uint128_t middle = (low_low >> 64) + static_cast<uint64_t>(low_high) + static_cast<uint64_t>(high_low);
+    low = middle << 64 | static_cast<uint64_t>(low_low);
+    high = high_high + (low_high >> 64) + (high_low >> 64) + (middle >> 64);
+}
+
+// The same reduction for 128-bit values, whose products need 256 bits; there
+// is no hardware divide for those, so this is also the fast path. mu needs
+// a 256 by 128-bit division, done bit by bit once per modulus.
+template<>
+struct barrett_t<__uint128_t> {
+    using T = __uint128_t;
+    using value_type = T;
+
+    explicit barrett_t(const T mod)
+    : mod{mod}
+    , shift{bit_length(mod) - 1}
+    , mu{0}
+    {
+        assert(mod > 2 && shift + 2 < 128 && (mod & (mod - 1)) != 0);
+
+        // 2^(128 + shift) / mod, one quotient bit at a time
+        T remainder = 0;
+        for(int bit = 128 + shift; bit >= 0; --bit) {
+            const bool carry = remainder >> 127;
+            remainder = remainder << 1 | (bit == 128 + shift ? 1 : 0);
+            mu <<= 1;
+            if(carry || remainder >= mod) {
+                remainder -= mod;
+                mu |= 1;
+            }
+        }
+    }
+
+    T mod;
+
+    T operator()(const T lhs, const T rhs) const {
+        T high, low, quotient, ignored;
+        multiply_wide(lhs, rhs, high, low);
+        multiply_wide(low >> shift | high << (128 - shift), mu, quotient, ignored);
+
+        T result = low - quotient * mod;
+        result = result >= mod ? result - mod : result;
+        return result >= mod ? result - mod : result;
+    }
+
+    private:
+    int shift; // k - 1
+    T mu;
+
+    static int bit_length(T value) {
+        int result = 0;
+        for(; value; value /= 2)
+            ++result;
+        return result;
+    }
+};
+#endif
+
+// The faster reducer for T: % where the doubled type has a hardware divide.
+template<class T>
+struct reducer_for {
+    using type = modulo_t<T>;
+};
+
+#ifdef __SIZEOF_INT128__
+template<>
+struct reducer_for<__uint128_t> {
+    using type = barrett_t<__uint128_t>;
+};
+#endif
+
+template<class T, class Reducer>
+__attribute__((pure))
+mat2x2<T> multiply(const mat2x2<T> &lhs, const mat2x2<T> &rhs, const Reducer &reduce) {
+    mat2x2<T> result;
 
     for(int i = 0; i < 2; ++i)
-        for(int j = 0; j < 2; ++j)
-            result[i][j] %= mod;
+        for(int j = 0; j < 2; ++j) {
+            const T sum = reduce(lhs[i][0], rhs[0][j]) + reduce(lhs[i][1], rhs[1][j]);
+            result[i][j] = sum >= reduce.mod ? sum - reduce.mod : sum;
+        }
 
     return result;
 }
 
-template<class T, class Idx=uint64_t>
+// base^exp, modulo reduce.mod
+template<class T, class Reducer, class Idx=uint64_t>
 __attribute__((pure))
-T fib(Idx idx, const T mod) {
+mat2x2<T> power_of(mat2x2<T> base, Idx exp, const Reducer &reduce) {
     auto res = defs<T>::id;
-    auto base = defs<T>::fib;
-    
-    if(idx == 0)
-        return 0;
 
-    --idx;
+    while(exp) {
+        if(exp % 2 == 1)
+            res = multiply(res, base, reduce);
+        base = multiply(base, base, reduce);
+        exp /= 2;
+    }
+
+    return res;
+}
+
+// Kernels: fib^idx = [[F(idx + 1), F(idx)], [F(idx), F(idx - 1)]], modulo reduce.mod
 
-    while(idx) {
-        if(idx % 2 == 1)
-            res = multiply(res, base, mod);
-        base = multiply(base, base, mod);
-        idx /= 2;
+// Repeated squaring of the matrix, eight products per bit.
+struct matrix_kernel_t {
+    template<class Reducer, class Idx>
+    __attribute__((pure))
+    static mat2x2<typename Reducer::value_type> power(const Idx idx, const Reducer &reduce) {
+        return power_of(defs<typename Reducer::value_type>::fib, idx, reduce);
     }
+};
+
+// Fast doubling of (F(k), F(k + 1)) from the top bit down, three products per bit:
+//   F(2k) = F(k) (2 F(k + 1) - F(k)),  F(2k + 1) = F(k)^2 + F(k + 1)^2
+struct doubling_kernel_t {
+    template<class Reducer, class Idx>
+    __attribute__((pure))
+    static mat2x2<typename Reducer::value_type> power(const Idx idx, const Reducer &reduce) {
+        using T = typename Reducer::value_type;
+        const T mod = reduce.mod;
+
+        Idx bit = 1;
+        while(bit <= idx / 2)
+            bit *= 2;
+
+        T a = 0, b = 1; // F(k), F(k + 1)
+        for(; bit; bit /= 2) {
+            const T even = reduce(a, sub(add(b, b, mod), a, mod));
+            const T odd = add(reduce(a, a), reduce(b, b), mod);
+            if(idx & bit) {
+                a = odd;
+                b = add(even, odd, mod);
+            } else {
+                a = even;
+                b = odd;
+            }
+        }
+
+        return {{ {{b, a}}, {{a, sub(b, a, mod)}} }};
+    }
+
+    private:
+    template<class T>
+    static T add(const T lhs, const T rhs, const T mod) {
+        const T sum = lhs + rhs;
+        return sum >= mod ? sum - mod : sum;
+    }
+
+    template<class T>
+    static T sub(const T lhs, const T rhs, const T mod) {
+        return lhs >= rhs ? lhs - rhs : lhs + (mod - rhs);
+    }
+};
 
-    return (res[1][0] + res[1][1]) % mod;
+template<class Kernel = matrix_kernel_t, class Reducer, class Idx=uint64_t>
+__attribute__((pure))
+typename Reducer::value_type fib(const Idx idx, const Reducer &reduce) {
+    return Kernel::power(idx, reduce)[0][1];
+}
+
+constexpr unsigned pow10(const unsigned exp) {
+    return exp ? 10 * pow10(exp - 1) : 1;
 }
 
-template<class T, class Idx=uint64_t>
-void lift(const Idx idx, const T pattern, const T target, const T power, const Idx lower_period) {
-    if(power > target) {
-        T ans = idx + 6 * target;
-        assert(fib(ans, target) == pattern);
-        throw ans; // quasi-CPS :)
+// The first lift levels, generated at compile time: the indices below
+// period = 6 * 10^Digits grouped by their Fibonacci number modulo
+// mod = 10^Digits, each group in the order the depth-first search reaches them
+// (root residue modulo 60 first, then one digit per level). The indices with
+// residue r are index[offset[r]], ..., index[offset[r + 1] - 1].
+template<unsigned Digits>
+struct lift_table_t {
+    static constexpr const unsigned mod = pow10(Digits);
+    static constexpr const unsigned period = 6 * mod;
+
+    constexpr lift_table_t()
+    : offset{}
+    , index{}
+    {
+        unsigned residue[period] = {};
+        for(unsigned i = 0, a = 0, b = 1; i < period; ++i) {
+            residue[i] = a;
+            const unsigned next = (a + b) % mod;
+            a = b;
+            b = next;
+        }
+
+        for(unsigned i = 0; i < period; ++i)
+            ++offset[residue[i] + 1];
+        for(unsigned r = 0; r < mod; ++r)
+            offset[r + 1] += offset[r];
+
+        unsigned filled[mod] = {};
+        for(unsigned key = 0; key < period; ++key) {
+            // key = root, d_1, ..., d_{Digits - 1} in decimal; idx = root + 60 d_1 + 600 d_2 + ...
+            unsigned idx = key / pow10(Digits - 1), step = 60;
+            for(unsigned rest = key % pow10(Digits - 1), i = 1; i < Digits; ++i, step *= 10)
+                idx += step * (rest / pow10(Digits - 1 - i) % 10);
+
+            index[offset[residue[idx]] + filled[residue[idx]]++] = static_cast<uint16_t>(idx);
+        }
     }
 
-    for(Idx i = 0; i < 10; ++i) {
-        auto candidx = idx + i * lower_period;
-        auto cand = fib(candidx, power);
-        if(cand % power == pattern % power)
-            lift(candidx, pattern, target, power * 10, lower_period * 10);
+    unsigned offset[mod + 1];
+    uint16_t index[period];
+};
+
+template<unsigned Digits>
+const lift_table_t<Digits>& lift_table() {
+    static constexpr const lift_table_t<Digits> table{};
+    return table;
+}
+
+// What the lift levels need that depends only on the pattern length, shared by
+// all the searches for that length: a Reducer modulo power for every level
+// and, when stepping incrementally, fib^lower_period modulo power.
+template<class T, class Reducer>
+struct levels_t {
+    levels_t(const T target, const bool incremental = true)
+    : target{target}
+    , incremental{incremental}
+    {
+        for(T power = 100, lower_period = 60; power <= target; power *= 10, lower_period *= 10) {
+            reducers.emplace_back(power);
+            if(incremental)
+                periods.push_back(power_of(defs<T>::fib, lower_period, reducers.back()));
+        }
+    }
+
+    unsigned size() const {
+        return static_cast<unsigned>(reducers.size());
     }
+
+    T target;
+    bool incremental;
+    std::vector<Reducer> reducers;
+    std::vector<mat2x2<T>> periods;
+};
+
+// Finds an index whose Fibonacci number ends with the pattern, lifting the
+// matching residues one digit at a time: a frame is an index modulo
+// lower_period whose Fibonacci number matches the pattern modulo power / 10,
+// and its children are the ten indices idx + i * lower_period modulo
+// 10 * lower_period. Frames live in one deque per worker; the owner takes the
+// newest (depth first), idle workers steal the oldest. The answer is the first
+// one a sequential depth-first search would find, so frames that can only
+// lead to later leaves are dropped once any answer is known. The products
+// modulo power go through Reducer; barrett_t avoids the divide, but loses to
+// it on CPUs with a fast 128-bit division. Kernel evaluates the
+// candidates, or only fib^idx of every frame when stepping incrementally.
+template<class T, class Idx=uint64_t, class Reducer=typename reducer_for<T>::type, class Kernel=doubling_kernel_t>
+class search_t {
+    public:
+    search_t(const T pattern, const levels_t<T, Reducer> &levels, const unsigned threads = 1)
+    : pattern{pattern}
+    , levels(levels)
+    , queues(std::max(1u, threads))
+    , pending{0}
+    , found{false}
+    , best{0}
+    , result{0}
+    { }
+
+    // Returns whether there is an answer and stores it in ans.
+    bool run(T &ans) {
+        switch(std::min(levels.size() + 1, 3u)) {
+            case 1: seed<1>(); break;
+            case 2: seed<2>(); break;
+            case 3: seed<3>(); break;
+        }
+
+        if(queues.size() == 1) {
+            work(0);
+        } else {
+            std::vector<std::thread> workers;
+            for(size_t self = 0; self < queues.size(); ++self)
+                workers.emplace_back([this, self] { work(self); });
+            for(auto &worker: workers)
+                worker.join();
+        }
+
+        ans = result;
+        return found;
+    }
+
+    private:
+    struct frame_t {
+        Idx idx;
+        T power;
+        Idx lower_period;
+        unsigned level;
+    };
+
+    struct queue_t {
+        std::mutex mutex;
+        std::deque<frame_t> frames;
+    };
+
+    const T pattern;
+    const levels_t<T, Reducer> &levels;
+
+    std::vector<queue_t> queues;
+    std::atomic<size_t> pending; // frames pushed but not yet expanded
+
+    std::mutex best_mutex;
+    std::atomic<bool> found;
+    Idx best;
+    T result;
+
+    // Whether the first level digits of idx (the root residue modulo 60, then
+    // one decimal digit per level) come after those of other, i.e. whether
+    // the depth-first search visits the subtree of idx after that of other.
+    static bool after(Idx idx, Idx other, const unsigned level) {
+        if(idx % 60 != other % 60)
+            return idx % 60 > other % 60;
+
+        idx /= 60;
+        other /= 60;
+        for(unsigned i = 0; i < level; ++i, idx /= 10, other /= 10)
+            if(idx % 10 != other % 10)
+                return idx % 10 > other % 10;
+
+        return false;
+    }
+
+    // Starts from the frames of level Digits - 1 straight from the table.
+    template<unsigned Digits>
+    void seed() {
+        const auto &table = lift_table<Digits>();
+        const auto residue = static_cast<unsigned>(pattern % table.mod);
+        const unsigned begin = table.offset[residue], end = table.offset[residue + 1];
+
+        for(unsigned i = end; i-- > begin; )
+            push((i - begin) % queues.size(), {table.index[i], 10 * table.mod, table.period, Digits - 1});
+    }
+
+    bool cancelled(const frame_t &frame) {
+        if(!found.load(std::memory_order_acquire))
+            return false;
+
+        std::lock_guard<std::mutex> lock{best_mutex};
+        return after(frame.idx, best, frame.level);
+    }
+
+    void push(const size_t self, const frame_t &frame) {
+        pending.fetch_add(1);
+        std::lock_guard<std::mutex> lock{queues[self].mutex};
+        queues[self].frames.push_back(frame);
+    }
+
+    bool pop(const size_t self, frame_t &frame) {
+        std::lock_guard<std::mutex> lock{queues[self].mutex};
+        if(queues[self].frames.empty())
+            return false;
+
+        frame = queues[self].frames.back();
+        queues[self].frames.pop_back();
+        return true;
+    }
+
+    bool steal(const size_t self, frame_t &frame) {
+        for(size_t i = 1; i < queues.size(); ++i) {
+            auto &victim = queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if(!victim.frames.empty()) {
+                frame = victim.frames.front();
+                victim.frames.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void work(const size_t self) {
+        frame_t frame;
+        while(pending.load() != 0) {
+            if(!pop(self, frame) && !steal(self, frame)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if(!cancelled(frame))
+                expand(self, frame);
+            pending.fetch_sub(1);
+        }
+    }
+
+    void expand(const size_t self, const frame_t &frame) {
+        if(frame.power > levels.target) {
+            T ans = frame.idx + 6 * levels.target;
+            assert(fib(ans, modulo_t<T>{levels.target}) == pattern);
+
+            std::lock_guard<std::mutex> lock{best_mutex};
+            if(!found.load() || after(best, frame.idx, levels.size())) {
+                best = frame.idx;
+                result = ans;
+                found.store(true, std::memory_order_release);
+            }
+            return;
+        }
+
+        // Children go in backwards, so that the smallest one is taken first.
+        std::array<Idx, 10> children;
+        size_t count = 0;
+        if(levels.incremental) {
+            // fib^n = [[F(n+1), F(n)], [F(n), F(n-1)]]
+            const auto &reduce = levels.reducers[frame.level];
+            auto current = Kernel::power(frame.idx, reduce);
+            for(Idx i = 0; i < 10; ++i) {
+                if(current[0][1] == pattern % frame.power)
+                    children[count++] = frame.idx + i * frame.lower_period;
+                if(i != 9)
+                    current = multiply(current, levels.periods[frame.level], reduce);
+            }
+        } else {
+            for(Idx i = 0; i < 10; ++i) {
+                auto candidx = frame.idx + i * frame.lower_period;
+                if(fib<Kernel>(candidx, levels.reducers[frame.level]) == pattern % frame.power)
+                    children[count++] = candidx;
+            }
+        }
+
+        while(count--)
+            push(self, {children[count], static_cast<T>(frame.power * 10), frame.lower_period * 10, frame.level + 1});
+    }
+};
+
+// Longest patterns for uint64_t and __uint128_t: 10^digits must fit, and the
+// moduli up to 10^digits must suit barrett_t.
+constexpr const size_t NARROW_DIGITS = 18;
+constexpr const size_t WIDE_DIGITS = 36;
+
+template<class T>
+std::string decimal(T value) {
+    std::string digits;
+    do {
+        digits += static_cast<char>('0' + static_cast<int>(value % 10));
+        value /= 10;
+    } while(value);
+
+    return {digits.rbegin(), digits.rend()};
 }
 
 template<class T>
-void solve(const T pattern, const T target) {
-    try {
-        for(int i = 0; i < 60; ++i) {
-            auto cand = fib(i, 10u);
-            if(cand % 10 == pattern % 10)
-                lift<T, uint64_t>(i, pattern, target, 100, 60);
-        }
-    } catch(T result) {
-        if(tests)
-            std::cout << "TAK" << std::endl;
-        else
-            std::cout << result << std::endl;
-        return;
+void print(std::ostream &out, const bool found, const T result) {
+    if(!found)
+        out << "NIE" << '\n';
+    else if(tests)
+        out << "TAK" << '\n';
+    else
+        out << decimal(result) << '\n';
+}
+
+// The pattern and 10^(its length)
+template<class T>
+void parse(const std::string &str, T &pattern, T &target) {
+    pattern = 0;
+    target = 1;
+    for(const char c: str) {
+        pattern = static_cast<T>(pattern * 10 + static_cast<T>(c - '0'));
+        target *= 10;
     }
+}
+
+template<class T>
+void solve(const std::string &str, const unsigned threads) {
+    T pattern, target;
+    parse(str, pattern, target);
+
+    const levels_t<T, typename reducer_for<T>::type> levels{target};
+    T result;
+    const bool found = search_t<T, T>{pattern, levels, threads}.run(result);
+    print(std::cout, found, result);
+}
+
+// Searches the patterns on threads workers, one pattern per worker at a time,
+// and prints the answers in input order; the throughput goes to stderr.
+// Patterns of the same length share their levels_t.
+template<class T>
+void solve_batch(const std::vector<std::string> &input, const unsigned threads) {
+    using clock = std::chrono::steady_clock;
+    using levels = levels_t<T, typename reducer_for<T>::type>;
+    static constexpr const size_t STEP = 64;
+
+    const auto start = clock::now();
+    std::vector<T> patterns(input.size());
+    std::map<size_t, levels> tables;
+    for(size_t i = 0; i < input.size(); ++i) {
+        T target;
+        parse(input[i], patterns[i], target);
+        if(!tables.count(input[i].size()))
+            tables.emplace(input[i].size(), levels{target});
+    }
+
+    std::vector<T> results(patterns.size());
+    std::vector<uint8_t> found(patterns.size());
+    std::atomic<size_t> next{0};
+
+    const auto work = [&] {
+        size_t begin;
+        while((begin = next.fetch_add(STEP)) < patterns.size())
+            for(size_t i = begin; i < std::min(begin + STEP, patterns.size()); ++i)
+                found[i] = search_t<T, T>{patterns[i], tables.at(input[i].size())}.run(results[i]);
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned thread = 1; thread < threads; ++thread)
+        workers.emplace_back(work);
+    work();
+    for(auto &worker: workers)
+        worker.join();
+
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    std::cerr << patterns.size() << " patterns of " << tables.size() << " lengths on "
+              << std::max(1u, threads) << " threads in " << elapsed.count() << " s, "
+              << static_cast<double>(patterns.size()) / elapsed.count() << " patterns/s" << std::endl;
+
+    for(size_t i = 0; i < patterns.size(); ++i)
+        print(std::cout, found[i] != 0, results[i]);
+}
+
+// Random numbers below bound, good enough for benchmarks.
+template<class T>
+T random_below(std::mt19937_64 &gen, const T bound) {
+    T value = 0;
+    for(size_t bits = 0; bits < sizeof(T) * 8; bits += 64)
+        value = static_cast<T>(value << 32 << 32 | gen());
+    return value % bound;
+}
+
+template<class T, class Reducer, class Kernel>
+void bench_search(const char *name, const std::vector<T> &input, const T target,
+                  const unsigned threads, const bool incremental) {
+    using clock = std::chrono::steady_clock;
+
+    size_t found = 0;
+    const auto start = clock::now();
+    const levels_t<T, Reducer> levels{target, incremental};
+    for(const auto pattern: input) {
+        T result;
+        if(search_t<T, T, Reducer, Kernel>{pattern, levels, threads}.run(result))
+            ++found;
+    }
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+
+    std::cerr << name << input.size() << " patterns (" << found << " found) on "
+              << threads << " threads in " << elapsed.count() << " s, "
+              << static_cast<double>(input.size()) / elapsed.count() << " patterns/s" << std::endl;
+}
 
-    std::cout << "NIE" << std::endl;
+// Times the ways of evaluating the candidates on the same random patterns of
+// the given length.
+template<class T>
+void bench(const size_t patterns, const size_t digits, const unsigned threads) {
+    std::mt19937_64 gen{2015};
+    T target = 1;
+    for(size_t i = 0; i < digits; ++i)
+        target *= 10;
+
+    std::vector<T> input(patterns);
+    for(auto &pattern: input)
+        pattern = random_below(gen, target);
+
+    using reducer = typename reducer_for<T>::type;
+    std::cerr << digits << " digits" << std::endl;
+    bench_search<T, reducer, matrix_kernel_t>("direct, matrix:         ", input, target, threads, false);
+    bench_search<T, reducer, doubling_kernel_t>("direct, doubling:       ", input, target, threads, false);
+    bench_search<T, reducer, matrix_kernel_t>("incremental, matrix:    ", input, target, threads, true);
+    bench_search<T, reducer, doubling_kernel_t>("incremental, doubling:  ", input, target, threads, true);
+    if(!std::is_same<reducer, barrett_t<T>>::value)
+        bench_search<T, barrett_t<T>, doubling_kernel_t>("incremental, Barrett:   ", input, target, threads, true);
 }
 
-int main() {
+template<class Kernel, class Reducer, class T>
+double bench_kernel(const std::vector<std::pair<T, T>> &input, T &checksum) {
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+    for(const auto &query: input)
+        checksum = checksum * 31 + fib<Kernel>(query.first, Reducer{query.second});
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+
+    return elapsed.count();
+}
+
+// Times both kernels on random indices and moduli up to 10^digits.
+template<class T>
+void bench_kernels(const size_t count, const size_t digits) {
+    using reducer = typename reducer_for<T>::type;
+
+    std::mt19937_64 gen{2015};
+    T bound = 1;
+    for(size_t i = 0; i < digits; ++i)
+        bound *= 10;
+
+    std::vector<std::pair<T, T>> input(count);
+    for(auto &query: input) {
+        query = {random_below(gen, static_cast<T>(~static_cast<T>(0))), random_below(gen, bound)};
+        if(query.second < 3 || (query.second & (query.second - 1)) == 0)
+            query.second += 3;
+    }
+
+    T matrix = 0, doubling = 0;
+    const auto matrix_time = bench_kernel<matrix_kernel_t, reducer>(input, matrix);
+    const auto doubling_time = bench_kernel<doubling_kernel_t, reducer>(input, doubling);
+
+    std::cerr << count << " indices of " << sizeof(T) * 8 << " bits, moduli up to 10^" << digits
+              << ", matrix: " << matrix_time / static_cast<double>(count) * 1e9
+              << " ns each, doubling: " << doubling_time / static_cast<double>(count) * 1e9
+              << " ns each" << (matrix == doubling ? "" : ", RESULTS DIFFER") << std::endl;
+}
+
+// Usage: fib [--threads k] [--batch | --bench [patterns [digits]] | --bench-kernels [count]]
+//   --threads       - searches every pattern on k threads (1 by default)
+//   --batch         - reads all the patterns first and searches k of them at
+//                     once instead
+//   --bench         - compares evaluating every candidate from scratch with
+//                     stepping from the period matrix, both kernels and, for
+//                     up to 18 digits, % with Barrett reduction, on random
+//                     patterns (18 digits by default) instead of reading the input
+//   --bench-kernels - compares the matrix and fast doubling kernels on random
+//                     64-bit indices and moduli up to 10^18, then on 128-bit
+//                     indices and moduli up to 10^36
+// Patterns of up to 18 digits are searched in 64 bits, longer ones, up to 36
+// digits, in 128 bits.
+int main(int argc, char **argv) {
+    unsigned threads = 1;
+    if(argc > 2 && std::string{argv[1]} == "--threads") {
+        threads = static_cast<unsigned>(std::stoul(argv[2]));
+        argc -= 2;
+        argv += 2;
+    }
+
+    if(argc > 1 && std::string{argv[1]} == "--bench-kernels") {
+        const auto count = argc > 2 ? std::stoul(argv[2]) : 1000000;
+        bench_kernels<uint64_t>(count, NARROW_DIGITS);
+        bench_kernels<__uint128_t>(count, WIDE_DIGITS);
+        return 0;
+    }
+
+    if(argc > 1 && std::string{argv[1]} == "--bench") {
+        const auto patterns = argc > 2 ? std::stoul(argv[2]) : 1000;
+        const auto digits = argc > 3 ? std::stoul(argv[3]) : NARROW_DIGITS;
+        if(digits <= NARROW_DIGITS)
+            bench<uint64_t>(patterns, digits, threads);
+        else
+            bench<__uint128_t>(patterns, std::min(digits, WIDE_DIGITS), threads);
+        return 0;
+    }
+
     std::ios_base::sync_with_stdio(false);
+    const bool batch = argc > 1 && std::string{argv[1]} == "--batch";
 
+    std::vector<std::string> input;
+    size_t longest = 0;
     std::string str;
     while(std::cin >> str) {
-        int64_t power = 1;
-        for(size_t i = 0; i < str.size(); ++i)
-            power *= 10;
+        if(str.size() > WIDE_DIGITS) {
+            std::cerr << "patterns of more than " << WIDE_DIGITS << " digits are not supported" << std::endl;
+            return 1;
+        }
 
-        auto pattern = std::stoll(str);
-        solve<uint64_t>(pattern, power);
+        if(batch) {
+            longest = std::max(longest, str.size());
+            input.push_back(str);
+        } else if(str.size() <= NARROW_DIGITS) {
+            solve<uint64_t>(str, threads);
+        } else {
+            solve<__uint128_t>(str, threads);
+        }
     }
+
+    if(batch && longest <= NARROW_DIGITS)
+        solve_batch<uint64_t>(input, threads);
+    else if(batch)
+        solve_batch<__uint128_t>(input, threads);
 }
@@ -1,9 +1,18 @@
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <numeric>
 #include <queue>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "fastio.h"
+
 //#define DEBUG
 
 #ifdef DEBUG
@@ -12,47 +21,95 @@ constexpr const bool debug = true;
 constexpr const bool debug = false;
 #endif
 
+// Compressed sparse rows with 32-bit targets: the neighbours of v are
+// targets[offsets[v]], ..., targets[offsets[v + 1] - 1]. Built in two
+// passes: add_edge() only records the edge and counts the degrees, finish()
+// turns the counts into offsets and lays the targets out.
 class graph_t {
-    private:
-        std::vector<std::vector<size_t>> adj;
     public:
         using vertex_t = size_t;
+        using target_t = uint32_t;
+
+        class range_t {
+            public:
+            range_t(const target_t *first, const target_t *last)
+            : first{first}
+            , last{last}
+            { }
+
+            const target_t* begin() const {
+                return first;
+            }
+
+            const target_t* end() const {
+                return last;
+            }
+
+            size_t size() const {
+                return static_cast<size_t>(last - first);
+            }
+
+            private:
+            const target_t *first, *last;
+        };
 
-        void resize(size_t sz) {
-            adj.clear();
-            adj.resize(sz);
+        void reset(size_t n, size_t m) {
+            assert(n <= std::numeric_limits<target_t>::max());
+            offsets.assign(n + 1, 0);
+            targets.clear();
+            edges.clear();
+            edges.reserve(2 * m);
         }
 
         void add_edge(vertex_t a, vertex_t b) {
-            adj[a].push_back(b);
-            adj[b].push_back(a);
+            edges.push_back(static_cast<target_t>(a));
+            edges.push_back(static_cast<target_t>(b));
+            ++offsets[a + 1];
+            ++offsets[b + 1];
         }
 
-        const std::vector<size_t>& operator[](size_t idx) const {
-            return adj[idx];
-        }
+        // offsets[v] is first the start of v and moves to its end while v's
+        // targets are filled in, which is the start of v + 1; shifting them
+        // back by one gives the final offsets without a second array.
+        void finish() {
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
 
-        auto begin() const -> decltype(adj.cbegin()) {
-            return adj.cbegin();
+            targets.resize(edges.size());
+            for(size_t i = 0; i < edges.size(); i += 2) {
+                targets[offsets[edges[i]]++] = edges[i + 1];
+                targets[offsets[edges[i + 1]]++] = edges[i];
+            }
+
+            std::vector<target_t>{}.swap(edges);
+            if(offsets.size() > 1)
+                std::copy_backward(offsets.begin(), offsets.end() - 2, offsets.end() - 1);
+            offsets[0] = 0;
         }
 
-        auto end() const -> decltype(adj.cend()) {
-            return adj.cend();
+        range_t operator[](size_t idx) const {
+            return {targets.data() + offsets[idx], targets.data() + offsets[idx + 1]};
         }
+
+    private:
+        std::vector<size_t> offsets;
+        std::vector<target_t> targets;
+        std::vector<target_t> edges; // pairs of endpoints until finish()
 };
 
 struct input_t {
     graph_t graph;
     size_t n, m, d;
 
-    friend std::istream& operator>>(std::istream &str, input_t &input) {
+    template<class Stream>
+    friend Stream& operator>>(Stream &str, input_t &input) {
         str >> input.n >> input.m >> input.d;
-        input.graph.resize(input.n);
+        input.graph.reset(input.n, input.m);
         for(size_t i = 0; i < input.m; ++i) {
             graph_t::vertex_t u, v;
             str >> u >> v;
             input.graph.add_edge(u - 1, v - 1);
         }
+        input.graph.finish();
         return str;
     }
 };
@@ -66,7 +123,8 @@ class output_t {
         std::sort(data.begin(), data.end());
     }
 
-    friend std::ostream& operator<<(std::ostream &str, const output_t &output) {
+    template<class Stream>
+    friend Stream& operator<<(Stream &str, const output_t &output) {
         if(output.data.empty())
             str << "NIE" << std::endl;
         else {
@@ -83,6 +141,53 @@ class output_t {
     std::vector<vertex_t> data;
 };
 
+// Union by size with path halving; every set also knows its smallest element.
+class disjoint_sets_t {
+    public:
+        explicit disjoint_sets_t(size_t n)
+        : parent(n)
+        , sizes(n, 1)
+        , smallest(n)
+        {
+            std::iota(parent.begin(), parent.end(), size_t{0});
+            std::iota(smallest.begin(), smallest.end(), size_t{0});
+        }
+
+        size_t find(size_t v) {
+            while(parent[v] != v) {
+                parent[v] = parent[parent[v]];
+                v = parent[v];
+            }
+            return v;
+        }
+
+        // Returns the root of the union.
+        size_t unite(size_t a, size_t b) {
+            a = find(a);
+            b = find(b);
+            if(a == b)
+                return a;
+
+            if(sizes[a] < sizes[b])
+                std::swap(a, b);
+            parent[b] = a;
+            sizes[a] += sizes[b];
+            smallest[a] = std::min(smallest[a], smallest[b]);
+            return a;
+        }
+
+        size_t size(size_t root) const {
+            return sizes[root];
+        }
+
+        size_t min(size_t root) const {
+            return smallest[root];
+        }
+
+    private:
+        std::vector<size_t> parent, sizes, smallest;
+};
+
 class solver_t {
     public:
         using vertex_t = graph_t::vertex_t;
@@ -93,20 +198,130 @@ class solver_t {
         solver_t(solver_t &&) = default;
 
         template<class Input>
-        explicit solver_t(Input &&input) 
+        explicit solver_t(Input &&input, unsigned threads = 1)
         : input(std::forward<Input>(input))
         , data(input.n)
+        , threads{std::max(1u, threads)}
         { }
 
         output_t operator()() && {
-            fill_degrees();
-            prepare_queue();
-            eliminate();
+            if(threads > 1) {
+                eliminate_parallel();
+            } else {
+                fill_degrees();
+                prepare_queue();
+                eliminate();
+            }
             auto c = get_component();
             return retrieve_component(c);
         }
 
+        // The answers for many thresholds d from one sweep: vertices join a
+        // union-find in order of decreasing coreness, so once those with
+        // coreness >= d are in, its sets are the components of the d-core.
+        // Ties go to the component with the smallest vertex, as in
+        // get_component().
+        std::vector<output_t> operator()(const std::vector<size_t> &thresholds) && {
+            std::vector<size_t> core;
+            const auto order = core_decomposition(core);
+
+            std::vector<size_t> queries(thresholds.size());
+            std::iota(queries.begin(), queries.end(), size_t{0});
+            std::sort(queries.begin(), queries.end(), [&thresholds](size_t a, size_t b) {
+                return thresholds[a] > thresholds[b];
+            });
+
+            std::vector<output_t> answers(thresholds.size());
+            disjoint_sets_t sets(input.n);
+            std::vector<uint8_t> added(input.n, 0);
+            size_t best_size = 0, best_min = 0;
+
+            const auto consider = [&](size_t root) {
+                if(sets.size(root) > best_size || (sets.size(root) == best_size && sets.min(root) < best_min)) {
+                    best_size = sets.size(root);
+                    best_min = sets.min(root);
+                }
+            };
+
+            auto next = order.rbegin();
+            for(const auto q: queries) {
+                for(; next != order.rend() && core[*next] >= thresholds[q]; ++next) {
+                    const auto v = *next;
+                    added[v] = 1;
+                    consider(v);
+                    for(const auto u: input.graph[v])
+                        if(added[u])
+                            consider(sets.unite(u, v));
+                }
+
+                if(best_size == 0)
+                    continue;
+
+                std::vector<vertex_t> component;
+                const auto root = sets.find(best_min);
+                for(auto it = order.rbegin(); it != next; ++it)
+                    if(sets.find(*it) == root)
+                        component.push_back(*it);
+                answers[q] = output_t{std::move(component)};
+            }
+
+            return answers;
+        }
+
     private:
+        // Batagelj and Zaversnik: the vertices sit in an array bucketed by
+        // their current degree, and the next one taken always has the
+        // smallest; its degree at that moment is its coreness. O(n + m).
+        // Returns the vertices in the order taken, i.e. by coreness.
+        std::vector<vertex_t> core_decomposition(std::vector<size_t> &core) const {
+            core.resize(input.n);
+            size_t max_degree = 0;
+            for(size_t v = 0; v < input.n; ++v) {
+                core[v] = input.graph[v].size();
+                max_degree = std::max(max_degree, core[v]);
+            }
+
+            // bin[k] is where the vertices of degree k start
+            std::vector<size_t> bin(max_degree + 1, 0);
+            for(size_t v = 0; v < input.n; ++v)
+                ++bin[core[v]];
+            for(size_t k = 0, start = 0; k <= max_degree; ++k) {
+                const auto count = bin[k];
+                bin[k] = start;
+                start += count;
+            }
+
+            std::vector<vertex_t> order(input.n);
+            std::vector<size_t> pos(input.n);
+            for(size_t v = 0; v < input.n; ++v) {
+                pos[v] = bin[core[v]]++;
+                order[pos[v]] = v;
+            }
+            for(size_t k = max_degree; k > 0; --k)
+                bin[k] = bin[k - 1];
+            bin[0] = 0;
+
+            // Moving u one bucket down: swap it with the first vertex of its
+            // bucket and move the bucket start past it.
+            for(size_t i = 0; i < input.n; ++i) {
+                const auto v = order[i];
+                for(const auto u: input.graph[v]) {
+                    if(core[u] <= core[v])
+                        continue;
+
+                    const auto first = bin[core[u]];
+                    const auto w = order[first];
+                    std::swap(order[pos[u]], order[first]);
+                    pos[w] = pos[u];
+                    pos[u] = first;
+                    ++bin[core[u]];
+                    --core[u];
+                }
+            }
+
+            return order;
+        }
+
         struct vertex_data {
             static constexpr const component_t NOT_VISITED = -1;
             bool removed;
@@ -151,38 +366,143 @@ class solver_t {
             }
         }
 
-        size_t dfs(const vertex_t v, const component_t c) {
-            if(data[v].component != vertex_data::NOT_VISITED)
-                return 0;
-
-            if(debug)
-                std::cerr << "dfs(" << v << ", " << c << ")" << std::endl;
+        // Calls fn(thread, begin, end) for threads parts of [0, size).
+        template<class Fn>
+        void parallel_for(const size_t size, Fn fn) const {
+            std::vector<std::thread> workers;
+            for(unsigned thread = 1; thread < threads; ++thread)
+                workers.emplace_back(fn, thread, size * thread / threads, size * (thread + 1) / threads);
+            fn(0u, size_t{0}, size / threads);
+            for(auto &worker: workers)
+                worker.join();
+        }
 
-            data[v].component = c;
-            size_t res = 1;
-            for(const auto u: input.graph[v])
-                if(!data[u].removed)
-                    res += dfs(u, c);
+        // Peels in rounds: every vertex of the frontier decrements its
+        // neighbours' degrees, and the one decrement that takes a degree from
+        // d to d - 1 puts that vertex into the next frontier. Degrees never
+        // grow, so each vertex is claimed once, and the survivors are the
+        // same d-core as eliminate() leaves. Small frontiers are not worth
+        // the threads and are peeled by the calling one.
+        void eliminate_parallel() {
+            static constexpr const size_t SEQUENTIAL = 1 << 12;
+
+            std::vector<std::atomic<size_t>> degree(input.n);
+            std::vector<std::vector<vertex_t>> next(threads);
+
+            parallel_for(input.n, [&](unsigned thread, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i) {
+                    degree[i].store(input.graph[i].size(), std::memory_order_relaxed);
+                    if(input.graph[i].size() < input.d)
+                        next[thread].push_back(i);
+                }
+            });
+
+            std::vector<vertex_t> frontier;
+            const auto gather = [&] {
+                frontier.clear();
+                for(auto &part: next) {
+                    frontier.insert(frontier.end(), part.begin(), part.end());
+                    part.clear();
+                }
+            };
+
+            const auto peel = [&](unsigned thread, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i)
+                    for(const auto v: input.graph[frontier[i]])
+                        if(degree[v].fetch_sub(1, std::memory_order_relaxed) == input.d)
+                            next[thread].push_back(v);
+            };
+
+            for(gather(); !frontier.empty(); gather()) {
+                if(frontier.size() < SEQUENTIAL)
+                    peel(0, 0, frontier.size());
+                else
+                    parallel_for(frontier.size(), peel);
+            }
 
-            return res;
+            parallel_for(input.n, [&](unsigned, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i) {
+                    data[i].degree = degree[i].load(std::memory_order_relaxed);
+                    data[i].removed = data[i].degree < input.d;
+                }
+            });
         }
 
+        // Components of the surviving vertices with a lock-free union-find:
+        // a root is only ever linked under a smaller one, so parents always
+        // point downwards (no cycles), every root is the smallest vertex of
+        // its set, and a union that loses a race simply retries. The labels
+        // are thus those the old depth-first search gave, and ties between
+        // the largest components still go to the one with the smallest vertex.
         component_t get_component() {
+            using target_t = graph_t::target_t;
+            std::vector<std::atomic<target_t>> parent(input.n);
+
+            const auto find = [&parent](target_t v) {
+                while(true) {
+                    auto p = parent[v].load(std::memory_order_relaxed);
+                    if(p == v)
+                        return v;
+
+                    const auto grandparent = parent[p].load(std::memory_order_relaxed);
+                    if(grandparent != p)
+                        parent[v].compare_exchange_weak(p, grandparent, std::memory_order_relaxed);
+                    v = grandparent;
+                }
+            };
+
+            const auto unite = [&parent, &find](target_t a, target_t b) {
+                while(true) {
+                    a = find(a);
+                    b = find(b);
+                    if(a == b)
+                        return;
+
+                    if(a < b)
+                        std::swap(a, b);
+                    auto expected = a;
+                    if(parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                        return;
+                }
+            };
+
+            parallel_for(input.n, [&](unsigned, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i)
+                    parent[i].store(static_cast<target_t>(i), std::memory_order_relaxed);
+            });
+
+            parallel_for(input.n, [&](unsigned, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i) {
+                    if(data[i].removed)
+                        continue;
+                    for(const auto u: input.graph[i])
+                        if(u > i && !data[u].removed)
+                            unite(u, static_cast<target_t>(i));
+                }
+            });
+
+            parallel_for(input.n, [&](unsigned, size_t begin, size_t end) {
+                for(size_t i = begin; i < end; ++i)
+                    if(!data[i].removed)
+                        data[i].component = find(static_cast<target_t>(i));
+            });
+
+            std::vector<size_t> sizes(input.n, 0);
+            for(size_t i = 0; i < input.n; ++i)
+                if(!data[i].removed)
+                    ++sizes[data[i].component];
+
             size_t best_size = 0;
             component_t best = vertex_data::NOT_VISITED;
+            for(size_t i = 0; i < input.n; ++i) {
+                if(debug && sizes[i])
+                    std::cerr << "Component with " << i << ": " << sizes[i] << std::endl;
 
-            for(size_t i = 0; i < input.n; ++i)
-                if(!data[i].removed && data[i].component == vertex_data::NOT_VISITED) {
-                    size_t current = dfs(i, i);
-                    
-                    if(debug)
-                        std::cerr << "Component with " << i << ": " << current << std::endl;
-
-                    if(current > best_size) {
-                        best_size = current;
-                        best = i;
-                    }
+                if(sizes[i] > best_size) {
+                    best_size = sizes[i];
+                    best = i;
                 }
+            }
 
             return best;
         }
@@ -201,11 +521,37 @@ class solver_t {
         const input_t input;
         std::vector<vertex_data> data;
         std::queue<vertex_t> queue;
+        unsigned threads;
 };
 
-int main() {
-    std::ios_base::sync_with_stdio(false);
+// Usage: mis [--threads k] [--queries]
+//   --threads - peels the graph and joins its components on k threads
+//   --queries - the graph is followed by q and q thresholds; answers each of
+//               them, in input order, as if it were d (d itself is ignored)
+int main(int argc, char **argv) {
+    unsigned threads = 1;
+    if(argc > 2 && std::string{argv[1]} == "--threads") {
+        threads = static_cast<unsigned>(std::stoul(argv[2]));
+        argc -= 2;
+        argv += 2;
+    }
+
+    fastio::reader_t in;
+    fastio::writer_t out;
     input_t input;
-    std::cin >> input;
-    std::cout << solver_t{std::move(input)}();
+    in >> input;
+
+    if(argc > 1 && std::string{argv[1]} == "--queries") {
+        size_t q;
+        in >> q;
+        std::vector<size_t> thresholds(q);
+        for(auto &d: thresholds)
+            in >> d;
+
+        for(const auto &answer: solver_t{std::move(input)}(thresholds))
+            out << answer;
+        return 0;
+    }
+
+    out << solver_t{std::move(input), threads}();
 }
@@ -5,6 +5,8 @@
 #include <limits>
 #include <vector>
 
+#include "fastio.h"
+
 #ifdef DEBUG
 static constexpr const bool debug = true;
 #else
@@ -25,7 +27,8 @@ struct graph_t {
     };
     std::vector<vertex_t> vertices;
 
-    friend std::istream& operator>>(std::istream &str, graph_t &input) {
+    template<class Stream>
+    friend Stream& operator>>(Stream &str, graph_t &input) {
         str >> input.n >> input.m;
         input.vertices.clear();
         input.vertices.resize(input.n);
@@ -145,7 +148,8 @@ int main() {
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
+    fastio::reader_t in;
     graph_t graph;
-    std::cin >> graph;
+    in >> graph;
     std::cout << solver_t{std::move(graph)}() << std::endl;
 }
@@ -7,6 +7,8 @@
 #include <utility>
 #include <vector>
 
+#include "fastio.h"
+
 #ifdef DEBUG
 static constexpr const bool debug = true;
 #else
@@ -19,11 +21,16 @@ struct input_t {
     std::vector<Money> initial;
     std::string cycle_string;
 
-    friend std::istream& operator>>(std::istream &str, input_t &input) {
+    template<class Stream>
+    friend Stream& operator>>(Stream &str, input_t &input) {
         str >> input.n;
         input.initial.clear();
         input.initial.reserve(input.n);
-        std::copy_n(std::istream_iterator<Money>(str), input.n, std::back_inserter(input.initial));
+        for(int64_t i = 0; i < input.n; ++i) {
+            Money money;
+            str >> money;
+            input.initial.push_back(money);
+        }
         str >> input.m >> input.cycle_string;
         return str;
     }
@@ -332,8 +339,9 @@ int main(int argc, char**) {
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
+    fastio::reader_t in;
     input_t<money_t> input;
-    std::cin >> input;
+    in >> input;
 
     if(argc > 1)
         std::cout << slow_solver_t<money_t, moves_t>{std::move(input)}() << std::endl;
@@ -7,6 +7,8 @@
 #include <stack>
 #include <vector>
 
+#include "fastio.h"
+
 //#define DEBUG
 
 #ifdef DEBUG
@@ -28,7 +30,8 @@ class graph_t {
     , timer{1}
     { }
 
-    friend std::istream& operator>>(std::istream &str, graph_t &graph) {
+    template<class Stream>
+    friend Stream& operator>>(Stream &str, graph_t &graph) {
         size_t n, m;
         str >> n >> m;
 
@@ -55,7 +58,8 @@ class graph_t {
         }
     }
 
-    void print_result(std::ostream &str) const {
+    template<class Stream>
+    void print_result(Stream &str) const {
         switch(state) {
             case state_t::NO_SCC:
                 str << "NIE" << std::endl;
@@ -221,11 +225,12 @@ class graph_t {
 };
 
 int main() {
-    std::ios_base::sync_with_stdio(false);
+    fastio::reader_t in;
+    fastio::writer_t out;
 
     graph_t graph;
-    std::cin >> graph;
+    in >> graph;
 
     graph.solve();
-    graph.print_result(std::cout);
+    graph.print_result(out);
 }
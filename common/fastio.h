@@ -0,0 +1,326 @@
+#ifndef PA2015_FASTIO_H
+#define PA2015_FASTIO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Drop-in replacements for std::cin/std::cout on large inputs.
+//
+// reader_t maps the whole input when it is a regular file and falls back to
+// large-block read(2) otherwise (pipes, terminals). It only understands
+// whitespace-separated integers and tokens, which is all the solutions need.
+// writer_t buffers everything and issues a single write(2) per block.
+namespace fastio {
+
+// The rest of a regular file (from its current offset on), mapped read-only.
+// Evaluates to false if fd is not a regular file or mapping it failed.
+class mapping_t {
+    public:
+    explicit mapping_t(int fd = 0)
+    : mapped{nullptr}
+    , size{0}
+    , offset{0}
+    {
+        struct stat st;
+        if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+            return;
+
+        const auto position = lseek(fd, 0, SEEK_CUR);
+        void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED)
+            return;
+
+        size = static_cast<size_t>(st.st_size);
+        mapped = static_cast<const char*>(addr);
+        offset = std::min(size, static_cast<size_t>(std::max<off_t>(position, 0)));
+        madvise(addr, size, MADV_SEQUENTIAL);
+    }
+
+    mapping_t(const mapping_t &) = delete;
+    mapping_t& operator=(const mapping_t &) = delete;
+
+    ~mapping_t() {
+        if(mapped)
+            munmap(const_cast<char*>(mapped), size);
+    }
+
+    explicit operator bool() const {
+        return mapped != nullptr;
+    }
+
+    const char* begin() const {
+        return mapped + offset;
+    }
+
+    const char* end() const {
+        return mapped + size;
+    }
+
+    private:
+    const char *mapped;
+    size_t size, offset;
+};
+
+class reader_t {
+    public:
+    static constexpr const size_t BLOCK = 1 << 20;
+
+    explicit reader_t(int fd = 0)
+    : fd{fd}
+    , mapping{fd}
+    , cur{mapping.begin()}
+    , end{mapping.end()}
+    , failed{false}
+    {
+        if(!mapping) {
+            buffer.resize(BLOCK);
+            cur = end = buffer.data();
+        }
+    }
+
+    reader_t(const reader_t &) = delete;
+    reader_t& operator=(const reader_t &) = delete;
+
+    explicit operator bool() const {
+        return !failed;
+    }
+
+    bool operator!() const {
+        return failed;
+    }
+
+    template<class T>
+    typename std::enable_if<std::is_integral<T>::value, reader_t&>::type
+    operator>>(T &value) {
+        if(!skip_whitespace())
+            return fail();
+
+        bool negative = false;
+        if(std::is_signed<T>::value && (*cur == '-' || *cur == '+')) {
+            negative = *cur == '-';
+            ++cur;
+        }
+
+        if(!available() || !is_digit(*cur))
+            return fail();
+
+        T result = 0;
+        while(available() && is_digit(*cur)) {
+            result = static_cast<T>(result * 10 + (*cur - '0'));
+            ++cur;
+        }
+
+        value = negative ? static_cast<T>(-result) : result;
+        return *this;
+    }
+
+    reader_t& operator>>(std::string &value) {
+        if(!skip_whitespace())
+            return fail();
+
+        value.clear();
+        while(available() && !is_space(*cur)) {
+            const auto *start = cur;
+            while(cur != end && !is_space(*cur))
+                ++cur;
+            value.append(start, cur);
+        }
+
+        return *this;
+    }
+
+    // How far into a mapped input reading has got, and a jump back (or
+    // forward) to such a position. seek() fails for an input that is not
+    // mapped, position() is then 0.
+    size_t position() const {
+        return mapping ? static_cast<size_t>(cur - mapping.begin()) : 0;
+    }
+
+    bool seek(size_t position) {
+        if(!mapping || position > static_cast<size_t>(mapping.end() - mapping.begin()))
+            return false;
+
+        cur = mapping.begin() + position;
+        failed = false;
+        return true;
+    }
+
+    // Skips the given number of tokens without converting them.
+    reader_t& skip(size_t tokens) {
+        while(tokens--) {
+            if(!skip_whitespace())
+                return fail();
+            while(available() && !is_space(*cur))
+                ++cur;
+        }
+        return *this;
+    }
+
+    private:
+    int fd;
+    mapping_t mapping;
+    const char *cur, *end;
+    std::vector<char> buffer;
+    bool failed;
+
+    static constexpr bool is_space(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static constexpr bool is_digit(char c) {
+        return '0' <= c && c <= '9';
+    }
+
+    bool refill() {
+        if(mapping)
+            return false;
+
+        ssize_t got;
+        do {
+            got = ::read(fd, buffer.data(), buffer.size());
+        } while(got < 0 && errno == EINTR);
+
+        cur = buffer.data();
+        end = cur + std::max<ssize_t>(got, 0);
+        return got > 0;
+    }
+
+    bool available() {
+        return cur != end || refill();
+    }
+
+    bool skip_whitespace() {
+        while(available()) {
+            while(cur != end && is_space(*cur))
+                ++cur;
+            if(cur != end)
+                return true;
+        }
+        return false;
+    }
+
+    reader_t& fail() {
+        failed = true;
+        return *this;
+    }
+};
+
+class writer_t {
+    public:
+    static constexpr const size_t BLOCK = 1 << 16;
+
+    explicit writer_t(int fd = 1)
+    : fd{fd}
+    , buffer(BLOCK)
+    , pos{0}
+    { }
+
+    writer_t(const writer_t &) = delete;
+    writer_t& operator=(const writer_t &) = delete;
+
+    ~writer_t() {
+        flush();
+    }
+
+    void flush() {
+        size_t done = 0;
+        while(done < pos) {
+            const auto written = ::write(fd, buffer.data() + done, pos - done);
+            if(written < 0) {
+                if(errno == EINTR)
+                    continue;
+                break;
+            }
+            done += static_cast<size_t>(written);
+        }
+        pos = 0;
+    }
+
+    template<class T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, writer_t&>::type
+    operator<<(T value) {
+        using unsigned_t = typename std::make_unsigned<T>::type;
+        char digits[std::numeric_limits<unsigned_t>::digits10 + 2];
+        size_t len = 0;
+
+        unsigned_t magnitude = static_cast<unsigned_t>(value);
+        if(value < 0) {
+            put('-');
+            magnitude = static_cast<unsigned_t>(0u - magnitude);
+        }
+
+        do {
+            digits[len++] = static_cast<char>('0' + magnitude % 10);
+            magnitude = static_cast<unsigned_t>(magnitude / 10);
+        } while(magnitude);
+
+        reserve(len);
+        while(len)
+            buffer[pos++] = digits[--len];
+        return *this;
+    }
+
+    writer_t& operator<<(char c) {
+        put(c);
+        return *this;
+    }
+
+    writer_t& operator<<(const char *str) {
+        return append(str, strlen(str));
+    }
+
+    writer_t& operator<<(const std::string &str) {
+        return append(str.data(), str.size());
+    }
+
+    // std::endl is only a newline, the buffer is flushed on destruction.
+    // Any other manipulator (std::flush) flushes the buffer right away.
+    writer_t& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+        if(manipulator == static_cast<std::ostream& (*)(std::ostream&)>(std::endl))
+            put('\n');
+        else
+            flush();
+        return *this;
+    }
+
+    private:
+    int fd;
+    std::vector<char> buffer;
+    size_t pos;
+
+    void reserve(size_t len) {
+        if(pos + len > buffer.size())
+            flush();
+    }
+
+    void put(char c) {
+        reserve(1);
+        buffer[pos++] = c;
+    }
+
+    writer_t& append(const char *str, size_t len) {
+        if(len > buffer.size()) {
+            flush();
+            buffer.resize(len);
+        }
+        reserve(len);
+        std::copy_n(str, len, buffer.data() + pos);
+        pos += len;
+        return *this;
+    }
+};
+
+}
+
+#endif
@@ -1,8 +1,54 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
+#include <time.h>
 
-static const unsigned LIMIT = 19 * 9 * 9;
+#include <pthread.h>
+
+/* The AVX2 kernel is only built for x86, elsewhere the scalar walk is all
+ * there is. */
+#if defined(__x86_64__) || defined(__i386__)
+#define AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+/* Numbers up to 2^128 have at most 39 digits, so their digit squares sum up
+ * to at most 39 * 81; only multiples k * mul with mul up to that can match. */
+#define MAX_DIGITS 39
+#define CHUNK_DIGITS 4
+#define CHUNK 10000u
+#define LIMBS ((MAX_DIGITS + CHUNK_DIGITS - 1) / CHUNK_DIGITS)
+#define LANES 8
+
+static const unsigned LIMIT = MAX_DIGITS * 9 * 9;
+
+#ifdef AVX2_KERNEL
+/* set once in main, before any worker starts */
+static int use_avx2;
+#endif
+
+/* digits_squares_sum of every 4-digit chunk, generated at compile time; the
+ * extra zero lets the vector gathers read 32 bits at the last entry */
+#define SQ4(a, b, c, d) ((a) * (a) + (b) * (b) + (c) * (c) + (d) * (d))
+#define SQ3(a, b, c) SQ4(a, b, c, 0), SQ4(a, b, c, 1), SQ4(a, b, c, 2), SQ4(a, b, c, 3), \
+    SQ4(a, b, c, 4), SQ4(a, b, c, 5), SQ4(a, b, c, 6), SQ4(a, b, c, 7), SQ4(a, b, c, 8), SQ4(a, b, c, 9)
+#define SQ2(a, b) SQ3(a, b, 0), SQ3(a, b, 1), SQ3(a, b, 2), SQ3(a, b, 3), SQ3(a, b, 4), \
+    SQ3(a, b, 5), SQ3(a, b, 6), SQ3(a, b, 7), SQ3(a, b, 8), SQ3(a, b, 9)
+#define SQ1(a) SQ2(a, 0), SQ2(a, 1), SQ2(a, 2), SQ2(a, 3), SQ2(a, 4), \
+    SQ2(a, 5), SQ2(a, 6), SQ2(a, 7), SQ2(a, 8), SQ2(a, 9)
+
+static const uint16_t chunk_squares[CHUNK + 1] = {
+    SQ1(0), SQ1(1), SQ1(2), SQ1(3), SQ1(4), SQ1(5), SQ1(6), SQ1(7), SQ1(8), SQ1(9)
+};
+
+/* a number in base 10^4, least significant limb first */
+typedef struct {
+    uint32_t limb[LIMBS];
+} limbs_t;
 
 unsigned digits_squares_sum(uint64_t num) {
     unsigned result = 0;
@@ -14,17 +60,299 @@ unsigned digits_squares_sum(uint64_t num) {
     return result;
 }
 
-int main() {
-    uint64_t k, a, b;
-    (void) scanf("%" SCNu64 "%" SCNu64 "%" SCNu64, &k, &a, &b);
+static limbs_t to_limbs(uint128_t num) {
+    limbs_t result;
+    unsigned i;
+    for(i = 0; i < LIMBS; ++i) {
+        result.limb[i] = (uint32_t) (num % CHUNK);
+        num /= CHUNK;
+    }
+    return result;
+}
+
+__attribute__((const))
+static unsigned limbs_needed(uint128_t num) {
+    unsigned result = 0;
+    while(num) {
+        ++result;
+        num /= CHUNK;
+    }
+    return result;
+}
+
+static void add_limbs(limbs_t *num, const limbs_t *addend, unsigned used) {
+    uint32_t carry = 0;
+    unsigned i;
+    for(i = 0; i < used; ++i) {
+        uint32_t sum = num->limb[i] + addend->limb[i] + carry;
+        carry = sum >= CHUNK;
+        num->limb[i] = carry ? sum - CHUNK : sum;
+    }
+}
+
+__attribute__((pure))
+static unsigned limbs_squares_sum(const limbs_t *num, unsigned used) {
+    unsigned result = 0, i;
+    for(i = 0; i < used; ++i)
+        result += chunk_squares[num->limb[i]];
+    return result;
+}
+
+/* Candidates k * mul for mul in [first, last], walked by adding k. */
+static unsigned count_scalar(uint128_t k, unsigned first, unsigned last, unsigned used) {
+    unsigned result = 0, mul;
+    limbs_t num = to_limbs(k * first), step = to_limbs(k);
+
+    for(mul = first; mul <= last; ++mul) {
+        if(limbs_squares_sum(&num, used) == mul)
+            ++result;
+        add_limbs(&num, &step, used);
+    }
+
+    return result;
+}
+
+#ifdef AVX2_KERNEL
+/* LANES consecutive candidates at once: limb i of every lane sits in one
+ * vector, the digit square sums are gathered from the table and the lanes
+ * advance by LANES * k. The tail is left to count_scalar. */
+__attribute__((target("avx2")))
+static unsigned count_avx2(uint128_t k, unsigned first, unsigned last, unsigned used) {
+    __m256i num[LIMBS], step[LIMBS];
+    const __m256i limit = _mm256_set1_epi32((int) CHUNK - 1);
+    const __m256i chunk = _mm256_set1_epi32((int) CHUNK);
+    const __m256i low = _mm256_set1_epi32(0xffff);
+    const __m256i lanes = _mm256_set1_epi32(LANES);
+    __m256i mul = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    unsigned result = 0, base, i, lane;
+
+    if(last - first + 1 < LANES)
+        return count_scalar(k, first, last, used);
+
+    for(i = 0; i < used; ++i) {
+        uint32_t start[LANES];
+        for(lane = 0; lane < LANES; ++lane)
+            start[lane] = to_limbs(k * (first + lane)).limb[i];
+        num[i] = _mm256_loadu_si256((const __m256i*) start);
+        step[i] = _mm256_set1_epi32((int) to_limbs(k * LANES).limb[i]);
+    }
+    mul = _mm256_add_epi32(mul, _mm256_set1_epi32((int) first));
+
+    for(base = first; base + LANES - 1 <= last; base += LANES) {
+        __m256i sum = _mm256_setzero_si256(), carry = _mm256_setzero_si256();
+
+        for(i = 0; i < used; ++i) {
+            const __m256i squares = _mm256_i32gather_epi32((const int*) chunk_squares, num[i], 2);
+            sum = _mm256_add_epi32(sum, _mm256_and_si256(squares, low));
+        }
+
+        result += (unsigned) __builtin_popcount((unsigned) _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(sum, mul))));
+
+        for(i = 0; i < used; ++i) {
+            const __m256i added = _mm256_add_epi32(_mm256_add_epi32(num[i], step[i]), carry);
+            const __m256i overflow = _mm256_cmpgt_epi32(added, limit);
+            num[i] = _mm256_sub_epi32(added, _mm256_and_si256(overflow, chunk));
+            carry = _mm256_srli_epi32(overflow, 31);
+        }
+        mul = _mm256_add_epi32(mul, lanes);
+    }
+
+    if(base <= last)
+        result += count_scalar(k, base, last, used);
+    return result;
+}
+#endif
+
+/* The number of x in [a, b] such that x = k * digits_squares_sum(x). Apart
+ * from the setup there is no division at all. */
+static unsigned count(uint128_t k, uint128_t a, uint128_t b) {
+    uint128_t first, last;
+    unsigned used;
+
+    if(k == 0)
+        return 0;
+
+    first = a / k + (a % k != 0);
+    last = b / k;
+    if(first < 1)
+        first = 1;
+    if(last > LIMIT)
+        last = LIMIT;
+    if(first > last)
+        return 0;
+
+    used = limbs_needed(k * last);
+#ifdef AVX2_KERNEL
+    if(use_avx2)
+        return count_avx2(k, (unsigned) first, (unsigned) last, used);
+#endif
+    return count_scalar(k, (unsigned) first, (unsigned) last, used);
+}
+
+static int read_number(uint128_t *num) {
+    char buffer[64];
+    const char *cur;
+
+    if(scanf("%63s", buffer) != 1)
+        return 0;
+
+    *num = 0;
+    for(cur = buffer; '0' <= *cur && *cur <= '9'; ++cur)
+        *num = *num * 10u + (unsigned) (*cur - '0');
+    return cur != buffer;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Every multiplier of the 64-bit range for random k: the original loop with
+ * digits_squares_sum, the chunked scalar walk and the AVX2 kernel. */
+static void bench(unsigned queries) {
+    static const uint64_t b = 1000000000000000000ull;
+    const unsigned limit = 19 * 9 * 9;
+    const unsigned used = limbs_needed(b);
+    uint64_t seed = 2015, total = 0;
+    unsigned expected = 0, got, q, mul;
+    double start;
 
-    unsigned count = 0, mul;
-    for(mul = 1; mul <= LIMIT && k * mul <= b; ++mul) {
-        if(digits_squares_sum(k * mul) == mul && a <= k * mul) {
-            ++count; 
+    start = now();
+    for(q = 0, seed = 2015; q < queries; ++q) {
+        const uint64_t k = 1 + (seed = seed * 6364136223846793005ull + 1442695040888963407ull) % 1000000;
+        for(mul = 1; mul <= limit && k * mul <= b; ++mul) {
+            expected += digits_squares_sum(k * mul) == mul;
+            ++total;
         }
     }
+    printf("digits_squares_sum: %.1f Mcandidates/s\n", (double) total / (now() - start) / 1e6);
+
+    start = now();
+    for(q = 0, seed = 2015, got = 0; q < queries; ++q) {
+        const uint64_t k = 1 + (seed = seed * 6364136223846793005ull + 1442695040888963407ull) % 1000000;
+        got += count_scalar(k, 1, (unsigned) (b / k < limit ? b / k : limit), used);
+    }
+    printf("scalar chunks: %.1f Mcandidates/s%s\n", (double) total / (now() - start) / 1e6,
+           got == expected ? "" : " (results differ!)");
+
+#ifdef AVX2_KERNEL
+    if(!use_avx2)
+        return;
+
+    start = now();
+    for(q = 0, seed = 2015, got = 0; q < queries; ++q) {
+        const uint64_t k = 1 + (seed = seed * 6364136223846793005ull + 1442695040888963407ull) % 1000000;
+        got += count_avx2(k, 1, (unsigned) (b / k < limit ? b / k : limit), used);
+    }
+    printf("avx2: %.1f Mcandidates/s%s\n", (double) total / (now() - start) / 1e6,
+           got == expected ? "" : " (results differ!)");
+#endif
+}
+
+typedef struct {
+    uint128_t k, a, b;
+    unsigned answer;
+} query_t;
+
+typedef struct {
+    query_t *queries;
+    size_t size;
+    size_t next; /* first query nobody has taken yet */
+} batch_t;
+
+#define BATCH_STEP 64
+#define MAX_THREADS 256
+
+/* Takes BATCH_STEP queries at a time until none are left. */
+static void* batch_worker(void *arg) {
+    batch_t *batch = (batch_t*) arg;
+    size_t begin, i;
+
+    while((begin = __atomic_fetch_add(&batch->next, BATCH_STEP, __ATOMIC_RELAXED)) < batch->size) {
+        const size_t end = begin + BATCH_STEP < batch->size ? begin + BATCH_STEP : batch->size;
+        for(i = begin; i < end; ++i)
+            batch->queries[i].answer = count(batch->queries[i].k, batch->queries[i].a, batch->queries[i].b);
+    }
+
+    return NULL;
+}
+
+/* Reads all the queries first, answers them on threads workers and prints
+ * the answers in input order; the throughput goes to stderr. There are never
+ * more workers than MAX_THREADS or blocks of queries; a worker that cannot
+ * be started leaves its share to the others, or to the calling thread. */
+static int solve_batch(unsigned threads) {
+    batch_t batch = { NULL, 0, 0 };
+    size_t capacity = 0;
+    pthread_t *workers;
+    query_t query;
+    unsigned thread, started;
+    size_t i;
+    double start;
+
+    while(read_number(&query.k) && read_number(&query.a) && read_number(&query.b)) {
+        if(batch.size == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            batch.queries = (query_t*) realloc(batch.queries, capacity * sizeof(query_t));
+            if(!batch.queries)
+                return 1;
+        }
+        batch.queries[batch.size++] = query;
+    }
+
+    if(threads > MAX_THREADS)
+        threads = MAX_THREADS;
+    if(threads > (batch.size + BATCH_STEP - 1) / BATCH_STEP)
+        threads = (unsigned) ((batch.size + BATCH_STEP - 1) / BATCH_STEP);
+    if(threads < 1)
+        threads = 1;
+    workers = (pthread_t*) malloc(threads * sizeof(pthread_t));
+    if(!workers)
+        return 1;
+
+    start = now();
+    for(started = 0; started < threads; ++started)
+        if(pthread_create(&workers[started], NULL, batch_worker, &batch) != 0)
+            break;
+    if(started == 0)
+        batch_worker(&batch);
+    for(thread = 0; thread < started; ++thread)
+        pthread_join(workers[thread], NULL);
+    threads = started ? started : 1;
+
+    fprintf(stderr, "%zu queries on %u threads: %.0f queries/s\n",
+            batch.size, threads, (double) batch.size / (now() - start));
+
+    for(i = 0; i < batch.size; ++i)
+        printf("%u\n", batch.queries[i].answer);
+
+    free(workers);
+    free(batch.queries);
+    return 0;
+}
+
+/* Answers every "k a b" triple on the input, one per line.
+ * With --threads n, reads them all first and answers them on n threads.
+ * With --bench [queries], compares the candidate checks instead. */
+int main(int argc, char **argv) {
+    uint128_t k, a, b;
+
+#ifdef AVX2_KERNEL
+    use_avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+
+    if(argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench(argc > 2 ? (unsigned) strtoul(argv[2], NULL, 10) : 100000);
+        return 0;
+    }
+
+    if(argc > 2 && strcmp(argv[1], "--threads") == 0)
+        return solve_batch((unsigned) strtoul(argv[2], NULL, 10));
+
+    while(read_number(&k) && read_number(&a) && read_number(&b))
+        printf("%u\n", count(k, a, b));
 
-    printf("%u\n", count);
     return 0;
 }
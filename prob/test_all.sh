@@ -1 +1 @@
-common/test_all.sh
\ No newline at end of file
+../common/test_all.sh
\ No newline at end of file